@@ -0,0 +1,168 @@
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+#include "../src/cow.hpp"
+#include "../src/sdl.hpp"
+
+// Forking machines for a tree search: every machine branches into 16, one per key held down for the next frame.
+// Usage: chip8-bench-fork roms/*/*.ch8
+//
+// Every ROM runs for a second, then the tree is expanded to DEPTH levels, both with copy-on-write machines
+// & with full copies of the machine (the baseline). Both run on a single interpreter, which forks are swapped into.
+// Memory per fork is the machine, plus the pages copied for it (copy-on-write) or the whole Chip8 (baseline).
+// Before that, two forks of the same machine are run for different amounts of frames, & have to end up where
+// the machine does when it's run alone on a runner of its own: nothing of one fork may leak into the next.
+
+using clock_type = std::chrono::steady_clock;
+
+constexpr u32 DEPTH = 3;
+constexpr u32 KEYS  = 16;
+
+struct Result {
+    double seconds = 0;
+    u64    forks   = 0;
+    u64    bytes   = 0;
+    u64    leaves  = 0;     // Hash of the leaves, which both have to agree on
+};
+
+static u64 combine(u64 hash, u64 value) {
+    return (hash ^ value) * 0x100000001b3ull;
+}
+
+static void copyOnWrite(ch8::Interface& interface, const char* path, Result& result) {
+    ch8::cow::Runner runner(interface, path);
+    std::vector<ch8::cow::Machine> level = {runner.Start()};
+
+    runner.Run(level[0], ch8::FRAME_RATE);
+    const u64 copied = runner.Copied();
+    auto start = clock_type::now();
+
+    for (u32 depth = 0; depth < DEPTH; ++depth) {
+        std::vector<ch8::cow::Machine> next;
+        next.reserve(level.size() * KEYS);
+
+        for (const auto& machine: level) {
+            for (u32 key = 0; key < KEYS; ++key) {
+                next.push_back(machine.Fork());
+                next.back().keys = u16(1u << key);
+                runner.Run(next.back(), 1);
+            }
+        }
+
+        result.forks += next.size();
+        level = std::move(next);
+    }
+
+    std::chrono::duration<double> elapsed = clock_type::now() - start;
+    result.seconds += elapsed.count();
+    result.bytes += (runner.Copied() - copied) * sizeof(ch8::cow::Page);
+
+    for (const auto& machine: level) {
+        result.leaves = combine(combine(result.leaves, machine.memoryHash), machine.pc);
+    }
+}
+
+static void fullCopy(ch8::Interface& interface, const char* path, Result& result) {
+    ch8::Chip8 state;
+    ch8::Program program(state, interface, path, 0);
+    std::vector<std::unique_ptr<ch8::Chip8>> level;
+    std::vector<i32> carried;   // By the recompiled code, for each machine of the level
+
+    program.Load();
+    for (u32 n = 0; n < ch8::FRAME_RATE; ++n) {
+        program.RunFrame();
+    }
+
+    level.push_back(std::make_unique<ch8::Chip8>(state));
+    carried.push_back(program.Carried());
+    auto start = clock_type::now();
+
+    for (u32 depth = 0; depth < DEPTH; ++depth) {
+        std::vector<std::unique_ptr<ch8::Chip8>> next;
+        std::vector<i32> nextCarried;
+        next.reserve(level.size() * KEYS);
+
+        for (std::size_t m = 0; m < level.size(); ++m) {
+            for (u32 key = 0; key < KEYS; ++key) {
+                state = *level[m];
+                state.keys = u16(1u << key);
+                program.Resume(carried[m]);
+                program.Stored(0, ch8::MEM_SIZE);    // The whole memory was swapped in
+                program.RunFrame();
+                next.push_back(std::make_unique<ch8::Chip8>(state));
+                nextCarried.push_back(program.Carried());
+            }
+        }
+
+        result.forks += next.size();
+        result.bytes += next.size() * sizeof(ch8::Chip8);
+        level = std::move(next);
+        carried = std::move(nextCarried);
+    }
+
+    std::chrono::duration<double> elapsed = clock_type::now() - start;
+    result.seconds += elapsed.count();
+
+    for (const auto& machine: level) {
+        result.leaves = combine(combine(result.leaves, machine->memoryHash), machine->pc);
+    }
+}
+
+static bool same(const ch8::cow::Machine& a, const ch8::cow::Machine& b) {
+    return a.v == b.v && a.stack == b.stack && a.i == b.i && a.sp == b.sp && a.pc == b.pc && a.dt == b.dt
+        && a.st == b.st && a.seed == b.seed && a.memoryHash == b.memoryHash && a.carried == b.carried;
+}
+
+static bool siblings(ch8::Interface& interface, const char* path) {
+    ch8::cow::Runner runner(interface, path);
+    ch8::cow::Machine root = runner.Start();
+    runner.Run(root, ch8::FRAME_RATE);
+
+    ch8::cow::Machine first = root.Fork(), second = root.Fork();
+    runner.Run(first, 1);
+    runner.Run(second, 2);
+
+    for (u32 frames: {1, 2}) {
+        ch8::cow::Runner fresh(interface, path);
+        ch8::cow::Machine alone = fresh.Start();
+        fresh.Run(alone, ch8::FRAME_RATE + frames);
+
+        if (!same(frames == 1 ? first : second, alone)) {
+            printf("%s: a fork run for %u frames doesn't match a fresh run\n", path, frames);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void report(const char* name, const Result& result, u64 machine) {
+    printf("%-14s %12.0f forks/s %10.1f bytes/fork\n", name, result.forks / result.seconds,
+           double(machine) + double(result.bytes) / result.forks);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("Usage: %s <rom>...\n", argv[0]);
+        return 1;
+    }
+
+    ch8::Interface interface;
+    Result cow, full;
+    bool separate = true;
+
+    for (int k = 1; k < argc; ++k) {
+        separate = siblings(interface, argv[k]) && separate;
+        copyOnWrite(interface, argv[k], cow);
+        fullCopy(interface, argv[k], full);
+    }
+
+    printf("%d ROMs, %u levels of %u keys\n", argc - 1, DEPTH, KEYS);
+    report("copy-on-write", cow, sizeof(ch8::cow::Machine));
+    report("full copy", full, 0);
+    printf("Leaves %s\n", cow.leaves == full.leaves ? "match" : "DON'T MATCH");
+    printf("Siblings %s\n", separate ? "match fresh runs" : "DON'T MATCH fresh runs");
+
+    return cow.leaves == full.leaves && separate ? 0 : 1;
+}
@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <vector>
+#include "../src/chip8.hpp"
+
+// Per-opcode microbenchmark: every instruction, alone in a tight loop, through the interpreter's own dispatch.
+// Usage: chip8-bench-opcodes [filter]   (only the cases whose name, pattern or mnemonic contains the filter)
+//
+// Every case is a synthetic ROM: registers set up once, then BODY copies of the instruction & a jump back to them.
+// Its time per instruction (the jump included, 1 in BODY + 1) is measured in TRIALS runs of STEPS instructions each,
+// after a warm-up, and reported as the best, median & mean, with the standard deviation across the trials.
+// Cases with variants (skips taken or not, sprites of several heights & alignments, Fx55/Fx65 over more registers)
+// show where a handler's cost depends on its operands. Opcodes without a case are listed at the end.
+
+using clock_type = std::chrono::steady_clock;
+
+constexpr u32 BODY    = 128;
+constexpr u32 WARM_UP = 1u << 16;
+constexpr u32 STEPS   = 1u << 18;
+constexpr u32 TRIALS  = 15;
+
+constexpr u16 SCRATCH = 0xe00;     // Between the ROM & the screen, for the instructions that store
+
+struct Case {
+    const char* name;
+    std::vector<u16> setup;                     // Executed once, after V0-VF are set to distinct values
+    std::function<u16(u16 address, u16 tail)> op;   // The instruction at an address of the body
+    std::vector<u16> tail;                      // After the jump back, at tail (subroutines)
+    u16 keys = 0;
+};
+
+static std::function<u16(u16, u16)> fixed(u16 opcode) {
+    return [opcode](u16, u16) { return opcode; };
+}
+
+static std::vector<Case> cases() {
+    std::vector<Case> all = {
+        {"",                  {},             fixed(0x00e0), {}},
+        {"",                  {},             fixed(0x0123), {}},
+        {"to the next",       {},             [](u16 address, u16) { return u16(0x1000 | (address + 2)); }, {}},
+        {"& RET",             {},             [](u16, u16 tail) { return u16(0x2000 | tail); }, {0x00ee}},
+        {"taken",             {},             fixed(0x3113), {}},
+        {"not taken",         {},             fixed(0x3100), {}},
+        {"taken",             {},             fixed(0x4100), {}},
+        {"not taken",         {},             fixed(0x4113), {}},
+        {"taken",             {},             fixed(0x5110), {}},
+        {"not taken",         {},             fixed(0x5120), {}},
+        {"",                  {},             fixed(0x6142), {}},
+        {"",                  {},             fixed(0x7103), {}},
+        {"",                  {},             fixed(0x8120), {}},
+        {"",                  {},             fixed(0x8121), {}},
+        {"",                  {},             fixed(0x8122), {}},
+        {"",                  {},             fixed(0x8123), {}},
+        {"",                  {},             fixed(0x8124), {}},
+        {"",                  {},             fixed(0x8125), {}},
+        {"",                  {},             fixed(0x8126), {}},
+        {"",                  {},             fixed(0x8127), {}},
+        {"",                  {},             fixed(0x812e), {}},
+        {"taken",             {},             fixed(0x9120), {}},
+        {"not taken",         {},             fixed(0x9110), {}},
+        {"",                  {},             fixed(0xa123), {}},
+        {"to the next",       {0x6002},       [](u16 address, u16) { return u16(0xb000 | address); }, {}},
+        {"",                  {},             fixed(0xc1a5), {}},
+        {"n=1, x=0",          {0x6100, 0x6200, 0xa000}, fixed(0xd121), {}},
+        {"n=5, x=0",          {0x6100, 0x6200, 0xa000}, fixed(0xd125), {}},
+        {"n=5, x=3",          {0x6103, 0x6200, 0xa000}, fixed(0xd125), {}},
+        {"n=5, x=62 clipped", {0x613e, 0x6200, 0xa000}, fixed(0xd125), {}},
+        {"n=8, x=0",          {0x6100, 0x6200, 0xa000}, fixed(0xd128), {}},
+        {"n=15, x=0",         {0x6100, 0x6200, 0xa000}, fixed(0xd12f), {}},
+        {"n=15, x=3",         {0x6103, 0x6200, 0xa000}, fixed(0xd12f), {}},
+        {"n=15, y=28 clipped",{0x6100, 0x621c, 0xa000}, fixed(0xd12f), {}},
+        {"pressed",           {0x6104},       fixed(0xe19e), {}, 1u << 4},
+        {"not pressed",       {0x6104},       fixed(0xe19e), {}},
+        {"pressed",           {0x6104},       fixed(0xe1a1), {}, 1u << 4},
+        {"not pressed",       {0x6104},       fixed(0xe1a1), {}},
+        {"",                  {},             fixed(0xf107), {}},
+        {"key held",          {},             fixed(0xf10a), {}, 1u << 9},
+        {"",                  {},             fixed(0xf115), {}},
+        {"",                  {},             fixed(0xf118), {}},
+        {"",                  {},             fixed(0xf11e), {}},
+        {"",                  {},             fixed(0xf129), {}},
+        {"",                  {0xa000 | SCRATCH}, fixed(0xf133), {}},
+        {"x=0",               {0xa000 | SCRATCH}, fixed(0xf055), {}},
+        {"x=3",               {0xa000 | SCRATCH}, fixed(0xf355), {}},
+        {"x=7",               {0xa000 | SCRATCH}, fixed(0xf755), {}},
+        {"x=15",              {0xa000 | SCRATCH}, fixed(0xff55), {}},
+        {"x=0",               {0xa000 | SCRATCH}, fixed(0xf065), {}},
+        {"x=3",               {0xa000 | SCRATCH}, fixed(0xf365), {}},
+        {"x=7",               {0xa000 | SCRATCH}, fixed(0xf765), {}},
+        {"x=15",              {0xa000 | SCRATCH}, fixed(0xff65), {}},
+    };
+
+    return all;
+}
+
+// V0-VE get distinct values (V1 is 0x13, V2 0x23 & so on), VF is 1. Then the setup, the body & the jump back.
+static std::vector<u8> assemble(const Case& c, u16& first) {
+    std::vector<u16> words;
+
+    for (u16 x = 0; x < 0xf; ++x) {
+        words.push_back(u16(0x6000 | x << 8 | (x << 4 | 3)));
+    }
+    words.push_back(0x6f01);
+    words.insert(words.end(), c.setup.begin(), c.setup.end());
+
+    const u16 body = u16(ch8::MEM_START + words.size() * 2);
+    const u16 tail = u16(body + (BODY + 1) * 2);
+
+    for (u32 n = 0; n < BODY; ++n) {
+        words.push_back(c.op(u16(body + n * 2), tail));
+    }
+    words.push_back(u16(0x1000 | body));
+    words.insert(words.end(), c.tail.begin(), c.tail.end());
+
+    std::vector<u8> bytes;
+    for (u16 word: words) {
+        bytes.push_back(u8(word >> 8));
+        bytes.push_back(u8(word));
+    }
+
+    first = c.op(body, tail);
+    return bytes;
+}
+
+int main(int argc, char** argv) {
+    const char* filter = argc > 1 ? argv[1] : "";
+
+    ch8::Chip8 state;
+    ch8::Program program(state, nullptr, 0);
+    bool covered[ch8::OP_COUNT] = {};
+
+    printf("%-5s %-7s %-19s %9s %9s %9s %8s\n", "op", "", "case", "best ns", "median", "mean", "stddev");
+
+    for (const Case& c: cases()) {
+        u16 opcode;
+        const std::vector<u8> rom = assemble(c, opcode);
+        const ch8::Pattern& pattern = ch8::PATTERNS[ch8::Classify(u8(opcode >> 8), u8(opcode))];
+        const char* nibbles = pattern.opcode == ch8::OP_NOP ? "0nnn" : pattern.pattern;
+
+        covered[pattern.opcode] = true;
+        for (u16 word: c.tail) {
+            covered[ch8::Classify(u8(word >> 8), u8(word))] = true;
+        }
+
+        if (!strstr(c.name, filter) && !strstr(nibbles, filter) && !strstr(pattern.mnemonic, filter)) {
+            continue;
+        }
+
+        program.Assign(rom.data(), rom.size());
+        program.Load();
+        state.keys = c.keys;
+
+        for (u32 n = 0; n < WARM_UP; ++n) {
+            program.Step();
+        }
+
+        std::vector<double> trials;
+
+        for (u32 trial = 0; trial < TRIALS; ++trial) {
+            auto start = clock_type::now();
+
+            for (u32 n = 0; n < STEPS; ++n) {
+                program.Step();
+            }
+
+            std::chrono::duration<double, std::nano> elapsed = clock_type::now() - start;
+            trials.push_back(elapsed.count() / STEPS);
+        }
+
+        double mean = 0, variance = 0;
+        for (double t: trials) {
+            mean += t / TRIALS;
+        }
+        for (double t: trials) {
+            variance += (t - mean) * (t - mean) / (TRIALS - 1);
+        }
+
+        std::sort(trials.begin(), trials.end());
+        printf("%-5s %-7s %-19s %9.2f %9.2f %9.2f %7.1f%%\n", nibbles, pattern.mnemonic, c.name,
+               trials.front(), trials[TRIALS / 2], mean, 100 * std::sqrt(variance) / mean);
+    }
+
+    for (u32 op = 0; op < ch8::OP_COUNT; ++op) {
+        if (!covered[op]) {
+            printf("No case for %s\n", ch8::PATTERNS[op].mnemonic);
+        }
+    }
+}
@@ -0,0 +1,76 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "../src/scaler.hpp"
+
+// Compares the SIMD scaler with the scalar one, at a few factors, with & without phosphor.
+// 12 is what an 800x600 window gets.
+
+using Expansion = void (ch8::Scaler::*)(const u8*, void*, i32) noexcept;
+
+static double measure(ch8::Scaler& scaler, Expansion expand, const u8* screen, std::vector<u32>& pixels, i32 pitch) {
+    using clock = std::chrono::steady_clock;
+
+    constexpr u32 FRAMES = 2000;
+    constexpr u32 TRIALS = 5;
+
+    // Warm up, then keep the best trial.
+    for (u32 n = 0; n < FRAMES / 10; ++n) {
+        (scaler.*expand)(screen, pixels.data(), pitch);
+    }
+
+    double best = 1e300;
+
+    for (u32 trial = 0; trial < TRIALS; ++trial) {
+        auto start = clock::now();
+
+        for (u32 n = 0; n < FRAMES; ++n) {
+            (scaler.*expand)(screen + (n % 2) * 256, pixels.data(), pitch);
+        }
+
+        std::chrono::duration<double, std::nano> elapsed = clock::now() - start;
+        if (elapsed.count() / FRAMES < best) {
+            best = elapsed.count() / FRAMES;
+        }
+    }
+
+    return best;
+}
+
+int main() {
+    // Two frames, so that the phosphor has something to fade.
+    u8 screen[512];
+    u32 seed = 0x2545f491u;
+
+    for (u8& byte: screen) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        byte = u8(seed);
+    }
+
+    printf("%-7s %-9s %12s %12s %9s %10s\n", "factor", "phosphor", "scalar ns", "simd ns", "speedup", "simd GB/s");
+
+    for (u32 factor: {1u, 4u, 12u, 18u}) {
+        for (bool phosphor: {false, true}) {
+            const i32 pitch = ch8::SCREEN_WIDTH * factor * sizeof(u32);
+            std::vector<u32> scalarPixels(ch8::SCREEN_WIDTH * factor * ch8::SCREEN_HEIGHT * factor);
+            std::vector<u32> simdPixels(scalarPixels.size());
+
+            ch8::Scaler scalar, simd;
+            scalar.factor = simd.factor = factor;
+            scalar.phosphor = simd.phosphor = phosphor;
+
+            double slow = measure(scalar, &ch8::Scaler::ExpandScalar, screen, scalarPixels, pitch);
+            double fast = measure(simd, &ch8::Scaler::Expand, screen, simdPixels, pitch);
+
+            // Both did the same amount of frames, so their output has to match.
+            bool same = scalarPixels == simdPixels && scalar.intensity == simd.intensity;
+            double bytes = double(scalarPixels.size() * sizeof(u32));
+
+            printf("%-7u %-9s %12.0f %12.0f %8.1fx %10.2f%s\n", factor, phosphor ? "yes" : "no",
+                   slow, fast, slow / fast, bytes / fast, same ? "" : "   MISMATCH");
+        }
+    }
+}
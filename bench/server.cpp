@@ -0,0 +1,180 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "../src/server.hpp"
+
+// Measures the control server (see src/server.hpp): start `chip8 serve <socket>` first.
+// Usage: chip8-bench-server <socket> <rom> [instances]
+//
+// ping:      one request per round trip, the protocol's floor
+// lockstep:  STEP 1 frame of one instance per round trip
+// pipelined: KEYS & STEP 1 frame for every instance, sent as one batch, then the answers are read
+
+using namespace ch8::server;
+using clock_type = std::chrono::steady_clock;
+
+static int server = -1;
+
+static void request(std::vector<u8>& out, u8 command, u16 instance, const void* payload, u32 length) {
+    const u8 header[HEADER_LEN] = {command, 0, u8(instance), u8(instance >> 8),
+                                   u8(length), u8(length >> 8), u8(length >> 16), u8(length >> 24)};
+
+    out.insert(out.end(), header, header + HEADER_LEN);
+    out.insert(out.end(), static_cast<const u8*>(payload), static_cast<const u8*>(payload) + length);
+}
+
+static void sendAll(const std::vector<u8>& bytes) {
+    for (std::size_t sent = 0; sent < bytes.size();) {
+        const ssize_t count = send(server, bytes.data() + sent, bytes.size() - sent, 0);
+
+        if (count <= 0) {
+            perror("send");
+            exit(1);
+        }
+
+        sent += count;
+    }
+}
+
+static void receiveAll(u8* bytes, std::size_t length) {
+    for (std::size_t received = 0; received < length;) {
+        const ssize_t count = recv(server, bytes + received, length - received, 0);
+
+        if (count <= 0) {
+            perror("recv");
+            exit(1);
+        }
+
+        received += count;
+    }
+}
+
+// Reads one response, returns its payload. Anything but STATUS_OK ends the benchmark.
+static std::vector<u8> response() {
+    u8 header[HEADER_LEN];
+    receiveAll(header, HEADER_LEN);
+
+    std::vector<u8> payload(header[4] | header[5] << 8 | header[6] << 16 | u32(header[7]) << 24);
+    receiveAll(payload.data(), payload.size());
+
+    if (header[0] != STATUS_OK) {
+        fprintf(stderr, "Command %u failed with status %u\n", header[1], header[0]);
+        exit(1);
+    }
+
+    return payload;
+}
+
+static void report(const char* name, u64 requests, u64 trips, clock_type::time_point start) {
+    std::chrono::duration<double> elapsed = clock_type::now() - start;
+    printf("%-10s %10.0f requests/s %10.0f round trips/s\n", name, requests / elapsed.count(), trips / elapsed.count());
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        printf("Usage: %s <socket> <rom> [instances]\n", argv[0]);
+        return 1;
+    }
+
+    std::ifstream file(argv[2], std::ios::binary);
+    const std::vector<u8> rom((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    const u32 count = argc > 3 ? u32(strtoul(argv[3], nullptr, 10)) : 100;
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, argv[1], sizeof(address.sun_path) - 1);
+
+    server = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (connect(server, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    std::vector<u8> batch;
+    std::vector<u16> instances;
+
+    // Set up the instances in one batch, too.
+    for (u32 n = 0; n < count; ++n) {
+        request(batch, COMMAND_CREATE, 0, nullptr, 0);
+    }
+    sendAll(batch);
+
+    for (u32 n = 0; n < count; ++n) {
+        auto id = response();
+        instances.push_back(u16(id[0] | id[1] << 8));
+    }
+
+    batch.clear();
+    for (u16 id: instances) {
+        request(batch, COMMAND_LOAD, id, rom.data(), u32(rom.size()));
+    }
+    sendAll(batch);
+
+    for (u32 n = 0; n < count; ++n) {
+        response();
+    }
+
+    constexpr u32 TRIPS = 100000;
+    const u8 frame[4] = {1, 0, 0, 0};
+    auto start = clock_type::now();
+
+    for (u32 n = 0; n < TRIPS; ++n) {
+        batch.clear();
+        request(batch, COMMAND_PING, 0, nullptr, 0);
+        sendAll(batch);
+        response();
+    }
+
+    report("ping", TRIPS, TRIPS, start);
+    start = clock_type::now();
+
+    for (u32 n = 0; n < TRIPS; ++n) {
+        batch.clear();
+        request(batch, COMMAND_STEP, instances[n % count], frame, 4);
+        sendAll(batch);
+        response();
+    }
+
+    report("lockstep", TRIPS, TRIPS, start);
+    start = clock_type::now();
+
+    const u32 batches = TRIPS / count + 1;
+
+    for (u32 n = 0; n < batches; ++n) {
+        batch.clear();
+
+        for (u32 k = 0; k < count; ++k) {
+            const u16 held = u16(1u << ((n + k) % 16));
+            const u8 keys[2] = {u8(held), u8(held >> 8)};
+
+            request(batch, COMMAND_KEYS, instances[k], keys, 2);
+            request(batch, COMMAND_STEP, instances[k], frame, 4);
+        }
+
+        sendAll(batch);
+
+        for (u32 k = 0; k < count * 2; ++k) {
+            response();
+        }
+    }
+
+    report("pipelined", u64(batches) * count * 2, batches, start);
+
+    batch.clear();
+    for (u16 id: instances) {
+        request(batch, COMMAND_DESTROY, id, nullptr, 0);
+    }
+    sendAll(batch);
+
+    for (u32 n = 0; n < count; ++n) {
+        response();
+    }
+
+    close(server);
+}
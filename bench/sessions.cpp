@@ -0,0 +1,65 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "../src/scheduler.hpp"
+#include "../src/sdl.hpp"
+
+// How many real-time (60 Hz) sessions one core sustains on the scheduler.
+// Usage: chip8-bench-sessions roms/*/*.ch8
+//
+// The sessions run the given ROMs in turn. Every session holds a key down now & then (a different one each time),
+// so games get going and waits for a key end, instead of the whole batch idling.
+// The count doubles until a tick of all the sessions no longer fits in a frame (16.7 ms), or the limit is reached.
+
+using clock_type = std::chrono::steady_clock;
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("Usage: %s <rom>...\n", argv[0]);
+        return 1;
+    }
+
+    constexpr u32 FRAMES = 300;
+    constexpr u32 LIMIT  = 1u << 14;
+    constexpr double BUDGET = 1000000.0 / ch8::FRAME_RATE;
+
+    ch8::Interface interface;
+
+    printf("%8s %12s %12s %12s %10s\n", "sessions", "tick (us)", "worst (us)", "per session", "waiting");
+
+    for (u32 count = 256; count <= LIMIT; count *= 2) {
+        ch8::Scheduler scheduler(interface);
+
+        for (u32 n = 0; n < count; ++n) {
+            scheduler.Add(argv[1 + n % (argc - 1)], 0, n * 0x9e3779b9u);
+        }
+
+        double total = 0, worst = 0;
+        u32 waiting = 0;
+
+        for (u32 frame = 0; frame < FRAMES; ++frame) {
+            for (u32 slot = 0; slot < count; ++slot) {
+                const u32 phase = (frame + slot) % 32;
+                scheduler.State(slot).keys = phase < 4 ? u16(1u << ((frame / 32 + slot) % 16)) : 0;
+            }
+
+            auto start = clock_type::now();
+            scheduler.Tick();
+            std::chrono::duration<double, std::micro> elapsed = clock_type::now() - start;
+
+            total += elapsed.count();
+            worst = std::max(worst, elapsed.count());
+            waiting += scheduler.Waiting();
+        }
+
+        const double tick = total / FRAMES;
+        printf("%8u %12.1f %12.1f %12.3f %9.1f%%\n", count, tick, worst, tick / count, 100.0 * waiting / (FRAMES * count));
+
+        if (tick > BUDGET) {
+            break;
+        }
+    }
+
+    printf("A frame is %.1f us: one core sustains about that divided by the time per session.\n", BUDGET);
+}
@@ -0,0 +1,55 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "../src/chip8.hpp"
+
+// Runs the interpreter's inner loop over a corpus of ROMs, without the frame loop around it (so idle frames count too).
+// Usage: chip8-bench-step roms/*/*.ch8
+//
+// Every ROM runs for the same amount of instructions, with no keys held down, ticking the timers once a frame.
+// Reports the average time per instruction over the whole corpus, which is what the machine's layout shows in.
+
+using clock_type = std::chrono::steady_clock;
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("Usage: %s <rom>...\n", argv[0]);
+        return 1;
+    }
+
+    constexpr u32 FRAMES = 100000;
+    constexpr u32 ROUNDS = 5;
+
+    ch8::Chip8 state;
+    double best = 0;
+
+    // The best round counts, the others are noise from the rest of the system.
+    for (u32 round = 0; round < ROUNDS; ++round) {
+        double total = 0;
+
+        for (int k = 1; k < argc; ++k) {
+            ch8::Program program(state, argv[k], 0);
+            program.Load();
+
+            auto start = clock_type::now();
+
+            for (u32 frame = 0; frame < FRAMES; ++frame) {
+                for (u32 n = 0; n < ch8::CYCLES_PER_FRAME; ++n) {
+                    program.Step();
+                }
+
+                state.TickTimers();
+            }
+
+            std::chrono::duration<double, std::nano> elapsed = clock_type::now() - start;
+            total += elapsed.count();
+        }
+
+        total /= double(FRAMES) * ch8::CYCLES_PER_FRAME * (argc - 1);
+        best = round == 0 ? total : std::min(best, total);
+    }
+
+    printf("%d ROMs, %.2f ns per instruction\n", argc - 1, best);
+    printf("machine: %zu bytes, aligned to %zu\n", sizeof(ch8::Chip8), alignof(ch8::Chip8));
+}
@@ -0,0 +1,53 @@
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "../src/terminal.hpp"
+
+// What the terminal frontend sends over the link: bytes per second of play, for every ROM & both kinds of glyphs.
+// Usage: chip8-bench-terminal roms/*/*.ch8
+//
+// Every ROM runs for a minute, holding a key down now & then (a different one each time) so games get going,
+// & every frame is drawn (a slow link would skip some, which only makes the output smaller).
+// The first frame, which clears the terminal, is counted too.
+
+constexpr u32 FRAMES = 60 * ch8::FRAME_RATE;
+
+static double rate(const char* path, ch8::terminal::GLYPHS glyphs) {
+    ch8::Chip8 state;
+    ch8::Program program(state, path, 0);
+    ch8::terminal::Renderer renderer(glyphs);
+    u64 bytes = 0;
+
+    program.Load();
+
+    for (u32 frame = 0; frame < FRAMES; ++frame) {
+        state.keys = frame % 90 < 10 ? u16(1u << (frame / 90 % 16)) : 0;
+        program.RunFrame();
+        bytes += renderer.Draw(&state.memory[ch8::SCREEN_START]).size();
+    }
+
+    return double(bytes) * ch8::FRAME_RATE / FRAMES;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("Usage: %s <rom>...\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<double> half, braille;
+
+    printf("%12s %12s  %s\n", "half (B/s)", "braille (B/s)", "ROM");
+
+    for (int k = 1; k < argc; ++k) {
+        half.push_back(rate(argv[k], ch8::terminal::GLYPHS_HALF));
+        braille.push_back(rate(argv[k], ch8::terminal::GLYPHS_BRAILLE));
+        printf("%12.0f %12.0f  %s\n", half.back(), braille.back(), argv[k]);
+    }
+
+    std::sort(half.begin(), half.end());
+    std::sort(braille.begin(), braille.end());
+    printf("%12.0f %12.0f  median\n", half[half.size() / 2], braille[braille.size() / 2]);
+    printf("%12.0f %12.0f  worst\n", half.back(), braille.back());
+}
@@ -0,0 +1,118 @@
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../src/defines.hpp"
+
+// Standalone driver for the fuzz target, for when libFuzzer isn't around.
+// Usage: chip8-fuzz-driver <iterations> [seed roms...]
+//
+// Without seeds, the inputs are random. With seeds, they are mutated copies of the seeds.
+// Whatever input crashes (or hangs for more than a second) is written to crash.ch8.
+// Build with sanitizers, and run with ASAN_OPTIONS=abort_on_error=1, so that their reports are caught as well.
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+static std::vector<u8> input;
+
+// Only async-signal-safe calls in here.
+static void onCrash(int signal) {
+    int file = creat("crash.ch8", 0644);
+    if (file >= 0) {
+        ssize_t written = write(file, input.data(), input.size());
+        (void)written;
+        close(file);
+    }
+
+    const char message[] = "\nInput written to crash.ch8\n";
+    ssize_t written = write(STDERR_FILENO, message, sizeof(message) - 1);
+    (void)written;
+
+    std::signal(signal, SIG_DFL);
+    std::raise(signal);
+}
+
+static u32 nextRandom(u32& seed) noexcept {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+static void mutate(std::vector<u8>& bytes, u32& seed) {
+    for (u32 count = nextRandom(seed) % 8 + 1; count > 0; --count) {
+        if (bytes.size() < 2) {
+            bytes.assign(2, 0);
+        }
+
+        u32 at = nextRandom(seed) % bytes.size();
+
+        switch (nextRandom(seed) % 4) {
+        case 0:     // Flip a bit
+            bytes[at] ^= 1u << (nextRandom(seed) % 8);
+            break;
+        case 1:     // Replace a byte
+            bytes[at] = u8(nextRandom(seed));
+            break;
+        case 2:     // Insert an instruction
+            if (bytes.size() + 2 <= ch8::MAX_PROG_LEN) {
+                bytes.insert(bytes.begin() + (at & ~1u), {u8(nextRandom(seed)), u8(nextRandom(seed))});
+            }
+            break;
+        case 3:     // Remove an instruction
+            bytes.erase(bytes.begin() + (at & ~1u), bytes.begin() + std::min<u32>((at & ~1u) + 2, bytes.size()));
+            break;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    using clock = std::chrono::steady_clock;
+
+    if (argc < 2) {
+        printf("Usage: %s <iterations> [seed roms...]\n", argv[0]);
+        return 1;
+    }
+
+    const unsigned long iterations = strtoul(argv[1], nullptr, 10);
+
+    std::vector<std::vector<u8>> seeds;
+    for (int i = 2; i < argc; ++i) {
+        std::ifstream file(argv[i], std::ios::binary);
+        seeds.emplace_back(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    for (int signal: {SIGSEGV, SIGABRT, SIGFPE, SIGILL, SIGBUS, SIGALRM}) {
+        std::signal(signal, onCrash);
+    }
+
+    input.reserve(ch8::MAX_PROG_LEN);
+    u32 seed = 0x2545f491u;
+
+    auto start = clock::now();
+
+    for (unsigned long n = 0; n < iterations; ++n) {
+        if (seeds.empty()) {
+            input.resize(nextRandom(seed) % 512);
+            for (u8& byte: input) {
+                byte = u8(nextRandom(seed));
+            }
+        } else {
+            input = seeds[nextRandom(seed) % seeds.size()];
+            mutate(input, seed);
+        }
+
+        alarm(1);
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+    }
+
+    alarm(0);
+
+    std::chrono::duration<double> elapsed = clock::now() - start;
+    printf("%lu inputs in %.2f s, %.0f execs/s\n", iterations, elapsed.count(), iterations / elapsed.count());
+}
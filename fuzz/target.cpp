@@ -0,0 +1,46 @@
+#include "../src/chip8.hpp"
+
+// libFuzzer entry point: runs the input as a program, for a bounded amount of frames.
+// The machine is created once, and wiped between inputs, so nothing but the changed instructions is reallocated.
+// CALL & RET keep sp within the stack themselves (a full stack drops the call), so there's nothing to check here:
+// the sanitizers catch whatever goes out of bounds.
+
+namespace {
+    constexpr u32 FRAMES = 32;
+
+    struct Harness {
+        ch8::Chip8   state;
+        ch8::Program program;
+
+        Harness()
+            : program(state, nullptr, 0)
+        {}
+    };
+}
+
+static Harness& harness() {
+    static Harness instance;
+    return instance;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    Harness& h = harness();
+    ch8::Chip8& state = h.state;
+
+    state.Wipe();
+    h.program.Assign(data, size);
+    h.program.Load();
+
+    for (u32 frame = 0; frame < FRAMES; ++frame) {
+        // Alternate between no key & each of the keys, so both sides of Ex9E, ExA1 & Fx0A get exercised.
+        state.keys = frame % 2 ? u16(1u << (frame / 2 % 16)) : 0;
+
+        for (u32 n = 0; n < ch8::CYCLES_PER_FRAME; ++n) {
+            h.program.Step();
+        }
+
+        state.TickTimers();
+    }
+
+    return 0;
+}
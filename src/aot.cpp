@@ -0,0 +1,472 @@
+#include <cstring>
+#include <set>
+#include <vector>
+#include "aot.hpp"
+#include "chip8.hpp"
+
+// Registry
+
+static std::vector<const ch8::aot::Image*>& images() noexcept {
+    // Function-local, so it's constructed before any generated translation unit registers itself.
+    static std::vector<const ch8::aot::Image*> registered;
+    return registered;
+}
+
+ch8::aot::Registrar::Registrar(const Image& image) noexcept {
+    images().push_back(&image);
+}
+
+const ch8::aot::Image* ch8::aot::Find(const std::vector<u8>& rom) noexcept {
+    for (auto image: images()) {
+        if (image->length == rom.size() && memcmp(image->rom, rom.data(), rom.size()) == 0) {
+            return image;
+        }
+    }
+
+    return nullptr;
+}
+
+
+// Dispatcher
+
+// Returns the block starting at pc, if there is one and it still matches the memory.
+static ch8::aot::Block lookup(const ch8::aot::Image& image, ch8::aot::Context& context) noexcept {
+    const u16 pc = context.state.pc;
+
+    u16 first = 0, last = image.count;
+    while (first < last) {
+        u16 middle = (first + last) / 2;
+
+        if (image.blocks[middle].address < pc) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+
+    if (first == image.count || image.blocks[first].address != pc) {
+        return nullptr;
+    }
+
+    const ch8::aot::BlockInfo& info = image.blocks[first];
+    if (context.dirty && memcmp(&context.state.memory[pc], image.rom + (pc - ch8::MEM_START), info.length) != 0) {
+        return nullptr;
+    }
+
+    return info.block;
+}
+
+void ch8::aot::Run(const Image& image, Context& context, Program& fallback) noexcept {
+    Chip8& state = context.state;
+    Block block = lookup(image, context);
+
+    while (context.cycles > 0) {
+        if (block == nullptr) {
+            // Interpret a single instruction, then try to get back into native code.
+            u8 l = state.At(state.pc);
+            u8 r = state.At(state.pc + 1);
+
+            fallback.Step();
+            --context.cycles;
+
+            switch (Classify(l, r)) {
+            case OP_LD_B:
+                Stored(context, state.i, 3, image.length);
+                break;
+            case OP_LD_I_V:
+                Stored(context, state.i, GetRightNibble(l) + 1, image.length);
+                break;
+            default:
+                break;
+            }
+        } else {
+            block = block(context).block;
+            if (block != nullptr && !context.dirty) {
+                continue;
+            }
+        }
+
+        block = lookup(image, context);
+    }
+}
+
+
+// Translator
+
+namespace {
+    enum Kind {
+        KIND_PLAIN,             // Falls through
+        KIND_STORE,             // Falls through, but may overwrite code
+        KIND_JUMP,
+        KIND_CALL,
+        KIND_RETURN,
+        KIND_JUMP_REGISTER,
+        KIND_SKIP,
+        KIND_WAIT               // Fx0A, which loops on itself
+    };
+
+    struct Rom {
+        const std::vector<u8>& bytes;
+
+        u16 End() const noexcept {
+            return ch8::MEM_START + bytes.size();
+        }
+
+        bool Contains(u16 address) const noexcept {
+            return address % 2 == 0 && address >= ch8::MEM_START && address < End();
+        }
+
+        u8 Left(u16 address) const noexcept {
+            return bytes[address - ch8::MEM_START];
+        }
+
+        u8 Right(u16 address) const noexcept {
+            return bytes[address - ch8::MEM_START + 1];
+        }
+
+        u16 Target(u16 address) const noexcept {
+            return ((u16(Left(address)) & 0x00f) << 8) | Right(address);
+        }
+    };
+}
+
+static Kind classify(u8 l, u8 r) noexcept {
+    switch (ch8::Classify(l, r)) {
+    case ch8::OP_RET:
+        return KIND_RETURN;
+    case ch8::OP_JP:
+        return KIND_JUMP;
+    case ch8::OP_CALL:
+        return KIND_CALL;
+    case ch8::OP_SE:
+    case ch8::OP_SNE:
+    case ch8::OP_SE_V:
+    case ch8::OP_SNE_V:
+    case ch8::OP_SKP:
+    case ch8::OP_SKNP:
+        return KIND_SKIP;
+    case ch8::OP_JP_V0:
+        return KIND_JUMP_REGISTER;
+    case ch8::OP_LD_K:
+        return KIND_WAIT;
+    case ch8::OP_LD_B:
+    case ch8::OP_LD_I_V:
+        return KIND_STORE;
+
+    default:
+        return KIND_PLAIN;
+    }
+}
+
+// Blocks start at the entry point, and wherever control flow can land, other than by falling through.
+static std::set<u16> findLeaders(const Rom& rom) {
+    std::set<u16> leaders;
+    std::vector<u16> work;
+
+    auto add = [&](u16 address) {
+        if (rom.Contains(address) && leaders.insert(address).second) {
+            work.push_back(address);
+        }
+    };
+
+    add(ch8::MEM_START);
+
+    while (!work.empty()) {
+        u16 address = work.back();
+        work.pop_back();
+
+        for (bool end = false; !end && rom.Contains(address); address += 2) {
+            end = true;
+
+            switch (classify(rom.Left(address), rom.Right(address))) {
+            case KIND_PLAIN:
+                end = false;
+                break;
+            case KIND_STORE:
+                add(address + 2);
+                break;
+            case KIND_JUMP:
+                add(rom.Target(address));
+                break;
+            case KIND_CALL:
+                add(rom.Target(address));
+                add(address + 2);
+                break;
+            case KIND_SKIP:
+                add(address + 2);
+                add(address + 4);
+                break;
+            case KIND_WAIT:
+                add(address);
+                add(address + 2);
+                break;
+            case KIND_RETURN:
+            case KIND_JUMP_REGISTER:
+                break;
+            }
+        }
+    }
+
+    return leaders;
+}
+
+static void emitSuccessor(FILE* out, const std::set<u16>& leaders, u16 address, const char* indent) {
+    fprintf(out, "%ss.pc = 0x%.3x;\n", indent, address);
+
+    if (leaders.count(address) != 0) {
+        fprintf(out, "%sreturn {B%.4x};\n", indent, address);
+    } else {
+        fprintf(out, "%sreturn {nullptr};\n", indent);
+    }
+}
+
+static void emitPlain(FILE* out, u8 l, u8 r) {
+    const u8 x = ch8::GetRightNibble(l);
+    const u8 y = ch8::GetLeftNibble(r);
+    const u8 n = ch8::GetRightNibble(r);
+
+    switch (ch8::Classify(l, r)) {
+    case ch8::OP_CLS:
+        fprintf(out, "    s.ClearScreen();\n");
+        return;
+
+    case ch8::OP_LD:
+        fprintf(out, "    s.v[0x%x] = 0x%.2x;\n", x, r);
+        return;
+    case ch8::OP_ADD:
+        fprintf(out, "    s.v[0x%x] += 0x%.2x;\n", x, r);
+        return;
+
+    case ch8::OP_LD_V:
+        fprintf(out, "    s.v[0x%x] = s.v[0x%x];\n", x, y);
+        return;
+    case ch8::OP_OR:
+        fprintf(out, "    s.v[0x%x] |= s.v[0x%x];\n", x, y);
+        return;
+    case ch8::OP_AND:
+        fprintf(out, "    s.v[0x%x] &= s.v[0x%x];\n", x, y);
+        return;
+    case ch8::OP_XOR:
+        fprintf(out, "    s.v[0x%x] ^= s.v[0x%x];\n", x, y);
+        return;
+    case ch8::OP_ADD_V:
+        fprintf(out, "    { u16 t = s.v[0x%x] + s.v[0x%x]; s.v[0x%x] = u8(t); s.v[0xf] = t > 0xff; }\n", x, y, x);
+        return;
+    case ch8::OP_SUB:
+        fprintf(out, "    { u8 f = s.v[0x%x] >= s.v[0x%x]; s.v[0x%x] -= s.v[0x%x]; s.v[0xf] = f; }\n", x, y, x, y);
+        return;
+    case ch8::OP_SHR:
+        fprintf(out, "    { u8 f = s.v[0x%x] & 0x1; s.v[0x%x] >>= 1; s.v[0xf] = f; }\n", x, x);
+        return;
+    case ch8::OP_SUBN:
+        fprintf(out, "    { u8 f = s.v[0x%x] >= s.v[0x%x]; s.v[0x%x] = s.v[0x%x] - s.v[0x%x]; s.v[0xf] = f; }\n", y, x, x, y, x);
+        return;
+    case ch8::OP_SHL:
+        fprintf(out, "    { u8 f = s.v[0x%x] >> 7; s.v[0x%x] <<= 1; s.v[0xf] = f; }\n", x, x);
+        return;
+
+    case ch8::OP_LD_I:
+        fprintf(out, "    s.i = 0x%.3x;\n", ((u16(l) & 0x00f) << 8) | r);
+        return;
+    case ch8::OP_RND:
+        fprintf(out, "    s.v[0x%x] = s.Random() & 0x%.2x;\n", x, r);
+        return;
+    case ch8::OP_DRW:
+        fprintf(out, "    s.v[0xf] = s.Draw(s.v[0x%x], s.v[0x%x], %u);\n", x, y, n);
+        return;
+
+    case ch8::OP_LD_V_DT:
+        fprintf(out, "    s.v[0x%x] = s.dt;\n", x);
+        return;
+    case ch8::OP_LD_DT:
+        fprintf(out, "    s.dt = s.v[0x%x];\n", x);
+        return;
+    case ch8::OP_LD_ST:
+        fprintf(out, "    s.st = s.v[0x%x];\n", x);
+        return;
+    case ch8::OP_ADD_I:
+        fprintf(out, "    { u32 t = s.i + s.v[0x%x]; s.i = u16(t); s.v[0xf] = t > 0xfff; }\n", x);
+        return;
+    case ch8::OP_LD_F:
+        fprintf(out, "    s.i = ch8::FONT_START + (s.v[0x%x] & 0xf) * 5;\n", x);
+        return;
+    case ch8::OP_LD_B:
+        fprintf(out, "    s.Store(s.i, s.v[0x%x] / 100); s.Store(s.i + 1, s.v[0x%x] / 10 %% 10); s.Store(s.i + 2, s.v[0x%x] %% 10);\n", x, x, x);
+        return;
+    case ch8::OP_LD_I_V:
+        for (u8 k = 0; k <= x; ++k) {
+            fprintf(out, "    s.Store(s.i + %u, s.v[0x%x]);\n", k, k);
+        }
+        return;
+    case ch8::OP_LD_V_I:
+        for (u8 k = 0; k <= x; ++k) {
+            fprintf(out, "    s.v[0x%x] = s.At(s.i + %u);\n", k, k);
+        }
+        return;
+
+    default:
+        // Control flow is emitted by emitBlock, anything else left is ignored.
+        fprintf(out, "    // ignored\n");
+        return;
+    }
+}
+
+static void emitSkip(FILE* out, const std::set<u16>& leaders, u16 address, u8 l, u8 r) {
+    const u8 x = ch8::GetRightNibble(l);
+    const u8 y = ch8::GetLeftNibble(r);
+    const ch8::OPCODE opcode = ch8::Classify(l, r);
+
+    switch (opcode) {
+    case ch8::OP_SE:
+        fprintf(out, "    if (s.v[0x%x] == 0x%.2x) {\n", x, r);
+        break;
+    case ch8::OP_SNE:
+        fprintf(out, "    if (s.v[0x%x] != 0x%.2x) {\n", x, r);
+        break;
+    case ch8::OP_SE_V:
+        fprintf(out, "    if (s.v[0x%x] == s.v[0x%x]) {\n", x, y);
+        break;
+    case ch8::OP_SNE_V:
+        fprintf(out, "    if (s.v[0x%x] != s.v[0x%x]) {\n", x, y);
+        break;
+    default:
+        fprintf(out, "    s.keysRead |= u16(1u << (s.v[0x%x] & 0xf));\n", x);
+        fprintf(out, "    if (%s(s.keys & (1u << (s.v[0x%x] & 0xf)))) {\n", opcode == ch8::OP_SKP ? "" : "!", x);
+        break;
+    }
+
+    emitSuccessor(out, leaders, address + 4, "        ");
+    fprintf(out, "    }\n");
+    emitSuccessor(out, leaders, address + 2, "    ");
+}
+
+static void emitBlock(FILE* out, const Rom& rom, const std::set<u16>& leaders, u16 start) {
+    fprintf(out, "Next B%.4x(Context& c) {\n    auto& s = c.state;\n", start);
+
+    u16 address = start;
+    u32 count = 0;
+
+    while (true) {
+        const u8 l = rom.Left(address);
+        const u8 r = rom.Right(address);
+        const Kind kind = classify(l, r);
+
+        fprintf(out, "    // %.4x: %.2x%.2x\n", address, l, r);
+        ++count;
+
+        if (kind == KIND_PLAIN) {
+            emitPlain(out, l, r);
+            address += 2;
+
+            if (!rom.Contains(address) || leaders.count(address) != 0) {
+                fprintf(out, "    c.cycles -= %u;\n", count);
+                emitSuccessor(out, leaders, address, "    ");
+                break;
+            }
+            continue;
+        }
+
+        fprintf(out, "    c.cycles -= %u;\n", count);
+
+        switch (kind) {
+        case KIND_STORE:
+            emitPlain(out, l, r);
+            fprintf(out, "    ch8::aot::Stored(c, s.i, %u, LENGTH);\n", ch8::Classify(l, r) == ch8::OP_LD_B ? 3 : ch8::GetRightNibble(l) + 1);
+            emitSuccessor(out, leaders, address + 2, "    ");
+            break;
+
+        case KIND_JUMP:
+            emitSuccessor(out, leaders, rom.Target(address), "    ");
+            break;
+
+        case KIND_CALL:
+            fprintf(out, "    if (s.sp < ch8::STACK_SIZE) {\n");
+            fprintf(out, "        s.stack[s.sp++] = 0x%.3x;\n", address + 2);
+            emitSuccessor(out, leaders, rom.Target(address), "        ");
+            fprintf(out, "    }\n");
+            emitSuccessor(out, leaders, address + 2, "    ");
+            break;
+
+        case KIND_RETURN:
+            fprintf(out, "    s.pc = 0x%.3x;\n", address + 2);
+            fprintf(out, "    if (s.sp > 0) {\n        s.pc = s.stack[--s.sp];\n    }\n");
+            fprintf(out, "    return {nullptr};\n");
+            break;
+
+        case KIND_JUMP_REGISTER:
+            fprintf(out, "    s.pc = u16(0x%.3x + s.v[0x0]);\n", rom.Target(address));
+            fprintf(out, "    return {nullptr};\n");
+            break;
+
+        case KIND_SKIP:
+            emitSkip(out, leaders, address, l, r);
+            break;
+
+        case KIND_WAIT:
+            fprintf(out, "    if (s.keys == 0) {\n");
+            emitSuccessor(out, leaders, address, "        ");
+            fprintf(out, "    }\n");
+            fprintf(out, "    u8 key = 0;\n    while (!(s.keys & (1u << key))) {\n        ++key;\n    }\n");
+            fprintf(out, "    s.keysRead |= u16(1u << key);\n");
+            fprintf(out, "    s.v[0x%x] = key;\n", ch8::GetRightNibble(l));
+            emitSuccessor(out, leaders, address + 2, "    ");
+            break;
+
+        case KIND_PLAIN:
+            break;
+        }
+        break;
+    }
+
+    fprintf(out, "}\n\n");
+}
+
+void ch8::aot::Translate(const std::vector<u8>& bytes, FILE* out) {
+    const Rom rom{bytes};
+    const std::set<u16> leaders = findLeaders(rom);
+
+    fprintf(out, "// Generated by `chip8 aot`, do not edit.\n\n");
+    fprintf(out, "#include \"../aot.hpp\"\n\n");
+    fprintf(out, "namespace {\n");
+    fprintf(out, "using ch8::aot::Context;\nusing ch8::aot::Next;\n\n");
+    fprintf(out, "constexpr u16 LENGTH = %u;\n\n", unsigned(bytes.size()));
+
+    fprintf(out, "const u8 rom[] = {");
+    for (std::vector<u8>::size_type i = 0; i < bytes.size(); ++i) {
+        fprintf(out, "%s0x%.2x,", i % 16 == 0 ? "\n    " : " ", bytes[i]);
+    }
+    fprintf(out, "%s\n};\n\n", bytes.empty() ? "\n    0x00" : "");
+
+    for (u16 address: leaders) {
+        fprintf(out, "Next B%.4x(Context& c);\n", address);
+    }
+    fprintf(out, "\n");
+
+    for (u16 address: leaders) {
+        emitBlock(out, rom, leaders, address);
+    }
+
+    if (leaders.empty()) {
+        fprintf(out, "const ch8::aot::BlockInfo* blocks = nullptr;\n\n");
+    } else {
+        fprintf(out, "const ch8::aot::BlockInfo blocks[] = {\n");
+        for (auto it = leaders.begin(); it != leaders.end(); ++it) {
+            // A block ends where the next one starts, at the latest.
+            u16 end = rom.End();
+            for (u16 address = *it; address < rom.End(); address += 2) {
+                Kind kind = classify(rom.Left(address), rom.Right(address));
+                if (kind != KIND_PLAIN || leaders.count(address + 2) != 0) {
+                    end = address + 2;
+                    break;
+                }
+            }
+
+            fprintf(out, "    {0x%.3x, %u, B%.4x},\n", *it, end - *it, *it);
+        }
+        fprintf(out, "};\n\n");
+    }
+
+    fprintf(out, "const ch8::aot::Image image = {rom, LENGTH, blocks, %u};\n", unsigned(leaders.size()));
+    fprintf(out, "const ch8::aot::Registrar registrar(image);\n");
+    fprintf(out, "}\n");
+}
@@ -0,0 +1,75 @@
+#ifndef GOGA_TAMAS_CHIP_8_AOT_HPP
+#define GOGA_TAMAS_CHIP_8_AOT_HPP
+
+#include <cstdio>
+#include <vector>
+#include "instructions.hpp"
+
+// Ahead-of-time recompilation.
+// The translator turns a ROM into a C++ translation unit with one function per basic block.
+// Once that translation unit is linked into the executable, it registers itself,
+// and the ROM is run natively whenever it's loaded. Anything the translator can't prove
+// (Bnnn targets, code outside the ROM, self-modified code) falls back to the interpreter.
+
+namespace ch8 {
+    class Program;
+
+    namespace aot {
+        struct Context;
+        struct Next;
+
+        // A block runs to its end, then returns its successor.
+        using Block = Next (*)(Context&);
+
+        // Direct jumps, calls & skips know their successor statically. Everything else returns nullptr,
+        // and the dispatcher looks up the block at pc.
+        struct Next {
+            Block block;
+        };
+
+        struct Context {
+            Chip8& state;
+            i32    cycles;  // Instructions left in the current time slice, may go negative
+            bool   dirty;   // Something was stored into the ROM, so blocks must be checked before being run
+        };
+
+        struct BlockInfo {
+            u16   address;
+            u16   length;   // In bytes
+            Block block;
+        };
+
+        // Emitted by the translator, one for each ROM.
+        struct Image {
+            const u8*        rom;
+            u16              length;
+            const BlockInfo* blocks;    // Sorted by address
+            u16              count;
+        };
+
+        // Generated translation units register their image through a static Registrar.
+        struct Registrar {
+            explicit Registrar(const Image& image) noexcept;
+        };
+
+        // Returns the registered image of the ROM, or nullptr if it wasn't recompiled.
+        const Image* Find(const std::vector<u8>& rom) noexcept;
+
+        // Runs until context.cycles is exhausted.
+        void Run(const Image& image, Context& context, Program& fallback) noexcept;
+
+        // Writes the translation unit of the ROM.
+        void Translate(const std::vector<u8>& rom, FILE* out);
+
+        // Called by generated code after a store of count bytes to address.
+        inline void Stored(Context& context, u16 address, u16 count, u16 length) noexcept {
+            u16 from = address & (MEM_SIZE - 1);
+
+            if (from < MEM_START + length && from + count > MEM_START) {
+                context.dirty = true;
+            }
+        }
+    }
+}
+
+#endif // GOGA_TAMAS_CHIP_8_AOT_HPP
@@ -1,227 +1,470 @@
+#include <cerrno>
+#include <cstring>
 #include <iostream>
 #include "chip8.hpp"
 
 // C-tors
 
-ch8::Program::Program(ch8::Chip8& state, ch8::Interface& interface, const char *path, u32 options)
+ch8::Program::Program(ch8::Chip8& state, const char* path, u32 options)
     : arguments(path, options)
     , state(state)
-    , interface(interface)
+    , context{state, 0, false}
 {
-    ParseBytes(os::ReadChip8File(arguments.path));
+    os::RomBuffer buffer;
+    loaded = os::LoadChip8File(arguments.path.c_str(), buffer);
+    Assign(buffer.data(), loaded.length);
+}
+
+ch8::Program::Program(ch8::Chip8& state, ch8::Interface& interface, const char* path, u32 options)
+    : Program(state, path, options)
+{
+    this->interface = &interface;
 }
 
 ch8::Program::Program(ch8::Chip8& state, ch8::Interface& interface, int argc, char **argv)
     : arguments(argc, argv)
     , state(state)
-    , interface(interface)
+    , interface(&interface)
+    , context{state, 0, false}
 {
-    ParseBytes(os::ReadChip8File(arguments.path));
+    if (arguments.IsEnabled(OPTIONS_STARTUP)) {
+        os::TraceStartup();
+        os::Mark("Arguments parsed");
+    }
+
+    os::RomBuffer buffer;
+    loaded = os::LoadChip8File(arguments.path.c_str(), buffer);
+    os::Mark("ROM read");
+
+    Assign(buffer.data(), loaded.length);
+    os::Mark("ROM decoded");
+
+    if (arguments.IsEnabled(OPTIONS_TRACE)) {
+        recorder = std::make_unique<trace::Recorder>(arguments.trace, arguments.IsEnabled(OPTIONS_COMPRESS));
+    }
+
+    if (arguments.IsEnabled(OPTIONS_PUBLISH)) {
+        publisher = std::make_unique<shared::Publisher>(arguments.publish);
+    }
 }
 
-void ch8::Program::ParseBytes(std::vector<u8> bytes) {
-    using std::make_unique;
+void ch8::Program::Assign(const u8* bytes, std::size_t length) {
+    rom.assign(bytes, bytes + std::min<std::size_t>(length, MAX_PROG_LEN));
 
-    program.clear();
-    program.reserve(bytes.size() / 2u);
-
-    for (std::vector<u8>::size_type i = 0; i < bytes.size(); i += 2) {
-        u8 l = bytes[i];
-        u8 r = bytes[i + 1];
-
-        switch (l >> 4) {
-        case 0x00:
-            switch (r) {
-            case 0xe0:
-                program.push_back(make_unique<ClearScreenInstruction>(state, interface, l, r));
-                break;
-            case 0xee:
-                program.push_back(make_unique<ReturnInstruction>(state, l, r));
-                break;
-
-            default:
-                // 0nnn: This instruction is only used on the old computers on which Chip-8 was originally implemented.
-                // It is ignored by modern interpreters.
-                program.push_back(make_unique<Instruction>(state, l, r));
-                break;
-            }
-            break;
-
-        case 0x01:
-            program.push_back(make_unique<JumpInstruction>(state, l, r));
-            break;
-        case 0x02:
-            program.push_back(make_unique<CallInstruction>(state, l, r));
-            break;
-        case 0x03:
-            program.push_back(make_unique<SkipEqualInstruction>(state, l, r));
-            break;
-        case 0x04:
-            program.push_back(make_unique<SkipNotEqualInstruction>(state, l, r));
-            break;
-        case 0x05:
-            program.push_back(make_unique<SkipRegisterEqualInstruction>(state, l, r));
-            break;
-        case 0x06:
-            program.push_back(make_unique<MoveInstruction>(state, l, r));
-            break;
-        case 0x07:
-            program.push_back(make_unique<AddInstruction>(state, l, r));
-            break;
-        case 0x08:
-            switch (GetRightNibble(r)) {
-            case 0x0:
-                program.push_back(make_unique<MoveRegisterInstruction>(state, l, r));
-                break;
-            case 0x1:
-                program.push_back(make_unique<OrInstruction>(state, l, r));
-                break;
-            case 0x2:
-                program.push_back(make_unique<AndInstruction>(state, l, r));
-                break;
-            case 0x3:
-                program.push_back(make_unique<XorInstruction>(state, l, r));
-                break;
-            case 0x4:
-                program.push_back(make_unique<AddRegisterInstruction>(state, l, r));
-                break;
-            case 0x5:
-                program.push_back(make_unique<SubInstruction>(state, l, r));
-                break;
-            case 0x6:
-                program.push_back(make_unique<ShiftRightInstruction>(state, l, r));
-                break;
-            case 0x7:
-                program.push_back(make_unique<SubInverseInstruction>(state, l, r));
-                break;
-            case 0xe:
-                program.push_back(make_unique<ShiftLeftInstruction>(state, l, r));
-                break;
-
-            default:
-                program.push_back(make_unique<Instruction>(state, l, r));
-                break;
-            }
-            break;
-        case 0x09:
-            program.push_back(make_unique<SkipRegisterNotEqualInstruction>(state, l, r));
-            break;
-        case 0x0a:
-            program.push_back(make_unique<MoveAddressInstruction>(state, l, r));
-            break;
-        case 0x0b:
-            program.push_back(make_unique<JumpRegisterInstruction>(state, l, r));
-            break;
-        case 0x0c:
-            program.push_back(make_unique<RandomMaskInstruction>(state, l, r));
-            break;
-        case 0x0d:
-            program.push_back(make_unique<DrawInstruction>(state, l, r));
-            break;
-        case 0x0e:
-            switch (r) {
-            case 0x9e:
-                program.push_back(make_unique<SkipKeyEqualsInstruction>(state, l, r));
-                break;
-            case 0xa1:
-                program.push_back(make_unique<SkipKeyNotEqualsInstruction>(state, l, r));
-                break;
-
-            default:
-                program.push_back(make_unique<Instruction>(state, l, r));
-                break;
-            }
-            break;
-        case 0x0f:
-            switch (r) {
-            case 0x07:
-                program.push_back(make_unique<GetDelayInstruction>(state, l, r));
-                break;
-            case 0x0a:
-                program.push_back(make_unique<GetKeyInstruction>(state, l, r));
-                break;
-            case 0x15:
-                program.push_back(make_unique<SetDelayInstruction>(state, l, r));
-                break;
-            case 0x18:
-                program.push_back(make_unique<SetSoundInstruction>(state, l, r));
-                break;
-            case 0x1e:
-                program.push_back(make_unique<AddToAddressInstruction>(state, l, r));
-                break;
-            case 0x29:
-                program.push_back(make_unique<SetSpriteInstruction>(state, l, r));
-                break;
-            case 0x33:
-                program.push_back(make_unique<SetBcdInstruction>(state, l, r));
-                break;
-            case 0x55:
-                program.push_back(make_unique<SaveRegistersInstruction>(state, l, r));
-                break;
-            case 0x65:
-                program.push_back(make_unique<LoadRegistersInstruction>(state, l, r));
-                break;
-
-            default:
-                program.push_back(make_unique<Instruction>(state, l, r));
-                break;
-            }
-            break;
+    // Padded like os::LoadChip8File does, so every way of loading a ROM runs the same bytes. MAX_PROG_LEN is even.
+    if (rom.size() % 2 != 0) {
+        rom.push_back(0);
+    }
+    ParseBytes();
+    image = aot::Find(rom);
+}
+
+// Instructions are decoded the first time they're needed (see Fetch), so that loading doesn't pay for data & dead code.
+// Instructions that still match the new bytes are kept.
+void ch8::Program::ParseBytes() {
+    program.resize(rom.size() / 2u);
 
-        default:
-            program.push_back(make_unique<Instruction>(state, l, r));
-            break;
+    for (size_type i = 0; i < program.size(); ++i) {
+        if (program[i] != nullptr && (program[i]->l != rom[i * 2] || program[i]->r != rom[i * 2 + 1])) {
+            program[i].reset();
         }
     }
 }
 
+ch8::Instruction& ch8::Program::Fetch(size_type index, u8 l, u8 r) {
+    auto& instruction = program[index];
+
+    if (instruction == nullptr || instruction->l != l || instruction->r != r) {
+        instruction = Decode(l, r);
+    }
+
+    return *instruction;
+}
+
+std::unique_ptr<ch8::Instruction> ch8::Program::Decode(u8 l, u8 r) const {
+    return Build(Classify(l, r), l, r);
+}
+
+std::unique_ptr<ch8::Instruction> ch8::Program::Build(OPCODE opcode, u8 l, u8 r) const {
+    using std::make_unique;
+
+    switch (opcode) {
+    case OP_CLS:     return make_unique<ClearScreenInstruction>(state, l, r);
+    case OP_RET:     return make_unique<ReturnInstruction>(state, l, r);
+    case OP_JP:      return make_unique<JumpInstruction>(state, l, r);
+    case OP_CALL:    return make_unique<CallInstruction>(state, l, r);
+    case OP_SE:      return make_unique<SkipEqualInstruction>(state, l, r);
+    case OP_SNE:     return make_unique<SkipNotEqualInstruction>(state, l, r);
+    case OP_SE_V:    return make_unique<SkipRegisterEqualInstruction>(state, l, r);
+    case OP_LD:      return make_unique<MoveInstruction>(state, l, r);
+    case OP_ADD:     return make_unique<AddInstruction>(state, l, r);
+    case OP_LD_V:    return make_unique<MoveRegisterInstruction>(state, l, r);
+    case OP_OR:      return make_unique<OrInstruction>(state, l, r);
+    case OP_AND:     return make_unique<AndInstruction>(state, l, r);
+    case OP_XOR:     return make_unique<XorInstruction>(state, l, r);
+    case OP_ADD_V:   return make_unique<AddRegisterInstruction>(state, l, r);
+    case OP_SUB:     return make_unique<SubInstruction>(state, l, r);
+    case OP_SHR:     return make_unique<ShiftRightInstruction>(state, l, r);
+    case OP_SUBN:    return make_unique<SubInverseInstruction>(state, l, r);
+    case OP_SHL:     return make_unique<ShiftLeftInstruction>(state, l, r);
+    case OP_SNE_V:   return make_unique<SkipRegisterNotEqualInstruction>(state, l, r);
+    case OP_LD_I:    return make_unique<MoveAddressInstruction>(state, l, r);
+    case OP_JP_V0:   return make_unique<JumpRegisterInstruction>(state, l, r);
+    case OP_RND:     return make_unique<RandomMaskInstruction>(state, l, r);
+    case OP_DRW:     return make_unique<DrawInstruction>(state, l, r);
+    case OP_SKP:     return make_unique<SkipKeyEqualsInstruction>(state, l, r);
+    case OP_SKNP:    return make_unique<SkipKeyNotEqualsInstruction>(state, l, r);
+    case OP_LD_V_DT: return make_unique<GetDelayInstruction>(state, l, r);
+    case OP_LD_K:    return make_unique<GetKeyInstruction>(state, l, r);
+    case OP_LD_DT:   return make_unique<SetDelayInstruction>(state, l, r);
+    case OP_LD_ST:   return make_unique<SetSoundInstruction>(state, l, r);
+    case OP_ADD_I:   return make_unique<AddToAddressInstruction>(state, l, r);
+    case OP_LD_F:    return make_unique<SetSpriteInstruction>(state, l, r);
+    case OP_LD_B:    return make_unique<SetBcdInstruction>(state, l, r);
+    case OP_LD_I_V:  return make_unique<SaveRegistersInstruction>(state, l, r);
+    case OP_LD_V_I:  return make_unique<LoadRegistersInstruction>(state, l, r);
+
+    default:
+        // 0nnn: This instruction is only used on the old computers on which Chip-8 was originally implemented.
+        // It is ignored by modern interpreters.
+        return make_unique<Instruction>(state, l, r);
+    }
+}
+
 void ch8::Program::DumpHex() const noexcept {
     if (program.size() == 0) {
         return;
     }
 
-    auto handle = program[0].get();
-    printf("%.4x:   %.2x%.2x ", MEM_START, handle->l, handle->r);
+    printf("%.4x:   %.2x%.2x ", MEM_START, rom[0], rom[1]);
 
     for (u32 i = 1u; i < program.size(); i++) {
-        handle = program[i].get();
-
         if (i % 8 == 0u) {
             printf("\n%.4x:   ", MEM_START + i * 2u);
         }
 
-        printf("%.2x%.2x ", handle->l, handle->r);
+        printf("%.2x%.2x ", rom[i * 2], rom[i * 2 + 1]);
     }
 
     putchar('\n');
 }
 
-void ch8::Program::Execute() noexcept {
+void ch8::Program::Load() noexcept {
     state.Reset();
 
-    bool isRunning = true;
-    SDL_Event event;
+    for (size_type k = 0; k < rom.size(); ++k) {
+        state.Store(MEM_START + k, rom[k]);
+    }
+
+    context.cycles = 0;
+    context.dirty = false;
+    Forget();
+}
+
+void ch8::Program::Step() noexcept {
+    const u16 pc = state.pc;
+    const u8 l = state.At(pc);
+    const u8 r = state.At(pc + 1);
+    const u32 index = (pc - MEM_START) / 2u;
 
-    // If start doesn't throw, we're guaranteed to have SDL set up correctly.
-    interface.Start("Chip-8", 800, 600);
-    interface.ClearScreen();
+    state.pc += 2;
 
-    while (isRunning) {
-        while (SDL_PollEvent(&event)) {
-            if (event.type == SDL_QUIT) {
-                isRunning = false;
+    // The decoded program is only a cache of the memory: self-modifying code gets decoded again.
+    if (pc % 2 == 0 && pc >= MEM_START && index < program.size()) {
+        Fetch(index, l, r).Execute();
+        return;
+    }
+
+    if (scratch == nullptr || scratch->l != l || scratch->r != r) {
+        scratch = Decode(l, r);
+    }
+
+    scratch->Execute();
+}
+
+std::unique_ptr<ch8::Instruction>* ch8::Program::Slot(u16 address) {
+    const u32 index = (address - MEM_START) / 2u;
+
+    if (address % 2 != 0 || address < MEM_START || index >= program.size()) {
+        return nullptr;
+    }
+
+    Fetch(index, state.At(address), state.At(address + 1));
+    return &program[index];
+}
+
+void ch8::Program::Stored(u16 address, u16 count) noexcept {
+    if (image != nullptr) {
+        aot::Stored(context, address, count, image->length);
+    }
+}
+
+void ch8::Program::Resume(i32 carried) noexcept {
+    context.cycles = carried;
+    Forget();
+}
+
+void ch8::Program::RunFrame() noexcept {
+    if (StillIdle()) {
+        phase = (phase + 1) % period;
+        Restore(recent[phase]);
+    } else if (recorder != nullptr) {
+        for (u32 n = 0; n < CYCLES_PER_FRAME; ++n) {
+            recorder->Before(state);
+            Step();
+            recorder->Step(state);
+        }
+
+        state.TickTimers();
+        recorder->Frame(state);
+    } else {
+        if (image != nullptr) {
+            context.cycles += CYCLES_PER_FRAME;
+            aot::Run(*image, context, *this);
+        } else {
+            for (u32 n = 0; n < CYCLES_PER_FRAME; ++n) {
+                Step();
             }
         }
+
+        state.TickTimers();
+        Observe();
+    }
+
+    if (publisher != nullptr) {
+        publisher->Publish(state);
+    }
+}
+
+void ch8::Program::RunFrames(u32 count) noexcept {
+    for (; count > 0 && !StillIdle(); --count) {
+        RunFrame();
+    }
+
+    if (count > 0) {
+        phase = (phase + count) % period;
+        Restore(recent[phase]);
+
+        if (publisher != nullptr) {
+            publisher->Publish(state);
+        }
     }
+}
+
+
+// Idle detection
+
+void ch8::Program::Save(Registers& registers) const noexcept {
+    registers.v = state.v;
+    registers.i = state.i;
+    registers.sp = state.sp;
+    registers.pc = state.pc;
+    registers.dt = state.dt;
+    registers.st = state.st;
+    registers.stack = state.stack;
+    registers.seed = state.seed;
+    registers.cycles = context.cycles;
+}
+
+void ch8::Program::Restore(const Registers& registers) noexcept {
+    state.v = registers.v;
+    state.i = registers.i;
+    state.sp = registers.sp;
+    state.pc = registers.pc;
+    state.dt = registers.dt;
+    state.st = registers.st;
+    state.stack = registers.stack;
+    state.seed = registers.seed;
+    context.cycles = registers.cycles;
+}
+
+bool ch8::Program::Matches(const Registers& registers) const noexcept {
+    return state.pc == registers.pc && state.v == registers.v && state.i == registers.i && state.sp == registers.sp
+        && state.dt == registers.dt && state.st == registers.st && state.stack == registers.stack
+        && state.seed == registers.seed && context.cycles == registers.cycles;
+}
+
+// The server & the debugger may change the machine between frames, so the cycle is only trusted while nothing did.
+bool ch8::Program::StillIdle() const noexcept {
+    return period != 0 && state.keys == recentKeys && state.memoryHash == recentMemory && Matches(recent[phase]);
+}
+
+// Called at the end of every executed frame. The memory is compared by its hash.
+void ch8::Program::Observe() noexcept {
+    period = 0;
+
+    if (recorder != nullptr) {
+        return;
+    }
+
+    if (state.memoryHash != recentMemory || state.keys != recentKeys) {
+        recentMemory = state.memoryHash;
+        recentKeys = state.keys;
+        recentCount = 0;
+    }
+
+    for (u32 k = 1; k <= recentCount; ++k) {
+        if (Matches(recent[recentCount - k])) {
+            std::copy(recent.begin() + (recentCount - k), recent.begin() + recentCount, recent.begin());
+            recentCount = k;
+            period = k;
+            phase = 0;
+            return;
+        }
+    }
+
+    if (recentCount == IDLE_PERIOD) {
+        std::copy(recent.begin() + 1, recent.end(), recent.begin());
+        --recentCount;
+    }
+
+    Save(recent[recentCount++]);
+}
+
+void ch8::Program::Forget() noexcept {
+    recentCount = 0;
+    period = 0;
+}
+
+// Golden traces
+
+u64 ch8::Program::HashRom() const noexcept {
+    u64 hash = 0xcbf29ce484222325ull;
+
+    for (u8 byte: rom) {
+        hash = (hash ^ byte) * 0x100000001b3ull;
+    }
+
+    return hash;
+}
+
+bool ch8::Program::Record(const std::string& path, u32 frames) {
+    GoldenTrace trace;
+    trace.rom = HashRom();
+    trace.frames.reserve(frames);
+
+    image = nullptr;
+    Load();
+
+    for (u32 n = 0; n < frames; ++n) {
+        RunFrame();
+        trace.frames.push_back(state.Hash());
+    }
+
+    if (!trace.Write(path)) {
+        printf("%s\n", trace.error.c_str());
+        return false;
+    }
+
+    printf("Recorded %u frames to %s\n", frames, path.c_str());
+    return true;
+}
+
+// Stops at the first divergent frame, so the machine is left as it was there.
+bool ch8::Program::Verify(const std::string& path) {
+    GoldenTrace golden;
+
+    if (!golden.Read(path)) {
+        printf("%s\n", golden.error.c_str());
+        return false;
+    }
+
+    if (golden.rom != HashRom() || golden.cycles != CYCLES_PER_FRAME) {
+        printf("%s was recorded with another ROM or timing\n", path.c_str());
+        return false;
+    }
+
+    image = nullptr;
+    Load();
+
+    for (std::size_t n = 0; n < golden.frames.size(); ++n) {
+        RunFrame();
+
+        const u64 hash = state.Hash();
+
+        if (hash != golden.frames[n]) {
+            printf("Frame %zu diverges: expected %.16llx, got %.16llx (pc %.4x, i %.4x)\n", n,
+                   (unsigned long long)golden.frames[n], (unsigned long long)hash, state.pc, state.i);
+            return false;
+        }
+    }
+
+    printf("All %zu frames match %s\n", golden.frames.size(), path.c_str());
+    return true;
+}
+
+bool ch8::Program::Export(Exporter& exporter, u32 frames) {
+    Load();
+
+    for (u32 n = 0; n < frames; ++n) {
+        RunFrame();
+
+        if (!exporter.Write(&state.memory[SCREEN_START])) {
+            fprintf(stderr, "Frame %u couldn't be written\n", n);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool ch8::Program::Optimize(const std::string& path, u32 frames) {
+    const optimizer::Result result = optimizer::Optimize(rom);
+    FILE* file = fopen(path.c_str(), "wb");
+
+    if (file == nullptr) {
+        printf("%s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    // An odd ROM was padded on load, & the padding isn't written back (unless a rewritten instruction now uses it).
+    std::size_t length = result.rom.size();
+    if (loaded.size < length && result.rom.back() == 0) {
+        length = loaded.size;
+    }
+
+    const bool written = fwrite(result.rom.data(), 1, length, file) == length;
+
+    if (fclose(file) != 0 || !written) {
+        printf("%s couldn't be written\n", path.c_str());
+        return false;
+    }
+
+    // Words that were stored into no longer are what was optimized, so they don't count.
+    u64 executed = 0, saved = 0;
+    Load();
+
+    for (u32 n = 0; n < frames; ++n) {
+        for (u32 k = 0; k < CYCLES_PER_FRAME; ++k, ++executed) {
+            const u32 index = (state.pc - MEM_START) / 2u;
+
+            if (state.pc % 2 == 0 && state.pc >= MEM_START && index < result.saved.size()
+                && state.At(state.pc) == rom[index * 2] && state.At(state.pc + 1) == rom[index * 2 + 1]) {
+                saved += result.saved[index];
+            }
+
+            Step();
+        }
+
+        state.TickTimers();
+    }
+
+    printf("%u jumps threaded, %u reloads removed, %u Fx1E folded into Annn, written to %s\n",
+           result.threaded, result.removed, result.folded, path.c_str());
+    printf("%llu of %llu executed instructions saved (%.2f%%) in %u frames\n", (unsigned long long)saved,
+           (unsigned long long)executed, executed != 0 ? 100.0 * saved / executed : 0.0, frames);
+    return true;
+}
 
-    interface.Stop();
+void ch8::Program::Recompile(FILE* out) const {
+    aot::Translate(rom, out);
 }
 
 void ch8::Program::Disassemble() noexcept {
     state.Reset();
 
-    for (const auto &instr: program) {
-        instr->Disassemble();
+    for (size_type i = 0; i < program.size(); ++i) {
+        Fetch(i, rom[i * 2], rom[i * 2 + 1]).Disassemble();
         putchar('\n');
         state.pc += 2;
     }
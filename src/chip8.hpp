@@ -1,11 +1,20 @@
 #ifndef GOGA_TAMAS_CHIP_8_PROGRAM_HPP
 #define GOGA_TAMAS_CHIP_8_PROGRAM_HPP
 
+#include <cstdio>
 #include <memory>
 #include "os.hpp"
+#include "aot.hpp"
+#include "golden.hpp"
+#include "export.hpp"
+#include "trace.hpp"
+#include "shared.hpp"
+#include "optimizer.hpp"
 #include "instructions.hpp"
 
 namespace ch8 {
+    struct Interface;
+
     // This object will act as the memory itself.
     class Program {
     public:
@@ -13,22 +22,130 @@ namespace ch8 {
         using size_type          = instruction_vector::size_type;
 
         const os::Arguments arguments;
+        os::LoadResult      loaded;     // How reading the ROM at the path went
         
+        // Headless: everything but Execute works without an interface.
+        Program(ch8::Chip8& state, const char* path, u32 options);
         Program(ch8::Chip8& state, ch8::Interface& interface, const char* path, u32 options);
         Program(ch8::Chip8& state, ch8::Interface& interface, int argc, char** argv);
 
         void DumpHex() const noexcept;
 
         void Disassemble() noexcept;
-        void Execute() noexcept;
+        // Throws if SDL or the window fails to start, or the program is headless.
+        void Execute();
+
+        // Writes the ROM as a C++ translation unit. See aot.hpp.
+        void Recompile(FILE* out) const;
+
+        // Replaces the ROM. Oversized ROMs are cut short, odd ones are padded with a zero.
+        void Assign(const u8* bytes, std::size_t length);
+
+        // Resets the machine & copies the ROM into its memory.
+        void Load() noexcept;
+
+        // Executes the instruction at pc.
+        void Step() noexcept;
+
+        // The decoded instruction at an address of the ROM (decoding it if needed), for the debugger to patch.
+        // nullptr outside of the ROM, where instructions aren't kept.
+        std::unique_ptr<Instruction>* Slot(u16 address);
+
+        // Stores made from outside of the machine (the server's pokes) have to be reported,
+        // so the recompiled code checks its blocks against the memory before running them again.
+        void Stored(u16 address, u16 count) noexcept;
+
+        // For running many machines on the same Chip8, swapping them in & out (see cow.hpp).
+        // Carried is what the recompiled code took over from the last frame, to be saved with the machine.
+        // Resume puts that back, & forgets what the idle detection saw of the machine swapped out.
+        // Report the memory that was swapped in with Stored, too.
+        i32 Carried() const noexcept {
+            return context.cycles;
+        }
+
+        void Resume(i32 carried) noexcept;
+
+        // Executes one frame's worth of instructions, then ticks the timers.
+        // While recording an execution trace, the interpreter is used, even if the ROM was recompiled:
+        // recompiled code runs whole blocks at a time, with no point between two instructions to record at.
+        // The result is published, if publishing was asked for.
+        // Idle frames aren't executed at all, see Idle.
+        void RunFrame() noexcept;
+
+        // The same as count calls to RunFrame, but once the machine is idle, the rest of the frames are skipped at once.
+        void RunFrames(u32 count) noexcept;
+
+        // Whether the machine is idle: it has been going around the same few states at the end of every frame,
+        // without the memory or the keys changing. JP to itself, waiting for a key (Fx0A or polling) & the like.
+        // A frame depends on nothing but the registers, the keys & the memory, so until the keys change
+        // (or something else pokes the machine), it keeps going around: frames just step to the next state.
+        bool Idle() const noexcept {
+            return period != 0;
+        }
+
+        // Whether the machine is blocked on Fx0A: the instruction at pc waits for a key, and none is held down.
+        // Until one is, frames do nothing but tick the timers.
+        bool Waiting() const noexcept {
+            return state.keys == 0 && Classify(state.At(state.pc), state.At(state.pc + 1)) == OP_LD_K;
+        }
+
+        // Headless runs, with no keys held down & a fixed seed, hashing the machine after every frame. See golden.hpp.
+        // Verify reports the first frame that doesn't match. Both return false on failure.
+        // Both use the interpreter, even if the ROM was recompiled: recompiled code counts cycles per block, so its frames
+        // end on other instructions, & a trace recorded with the image linked in wouldn't verify without it (or the other way).
+        bool Record(const std::string& path, u32 frames);
+        bool Verify(const std::string& path);
+
+        // Writes the optimized ROM (see optimizer.hpp), then runs the original headless like the above, counting
+        // the instructions the optimized one doesn't need to execute. Returns false if the ROM couldn't be written.
+        bool Optimize(const std::string& path, u32 frames);
+
+        // Headless run like the above, handing every frame to the exporter. Returns false if a frame couldn't be written.
+        bool Export(Exporter& exporter, u32 frames);
 
     private:
-        void ParseBytes(std::vector<u8> bytes);
+        void ParseBytes();
+        std::unique_ptr<Instruction> Decode(u8 l, u8 r) const;
+        std::unique_ptr<Instruction> Build(OPCODE opcode, u8 l, u8 r) const;
+        Instruction& Fetch(size_type index, u8 l, u8 r);
+        u64 HashRom() const noexcept;
+
+        // Idle detection.
+        struct Registers {
+            std::array<u8, 16>          v;
+            u16                         i, sp, pc;
+            u8                          dt, st;
+            std::array<u16, STACK_SIZE> stack;
+            u32                         seed;
+            i32                         cycles;     // Left over by the recompiled code, which it carries into the next frame
+        };
+
+        static constexpr u32 IDLE_PERIOD = 8;       // Longest cycle of frames that's recognized
+
+        void Save(Registers& registers) const noexcept;
+        void Restore(const Registers& registers) noexcept;
+        bool Matches(const Registers& registers) const noexcept;
+        bool StillIdle() const noexcept;
+        void Observe() noexcept;
+        void Forget() noexcept;
 
         Chip8& state;
-        Interface& interface;
+        Interface* interface = nullptr;
 
         instruction_vector program;
+        std::unique_ptr<Instruction> scratch;   // For instructions outside of the ROM
+        std::vector<u8> rom;
+        const aot::Image* image = nullptr;      // The ROM's native code, if it was recompiled
+        aot::Context context;
+        std::unique_ptr<trace::Recorder> recorder;
+        std::unique_ptr<shared::Publisher> publisher;   // Publishes the machine after every frame
+
+        std::array<Registers, IDLE_PERIOD> recent;  // The ends of the last frames, since the memory & keys last changed
+        u32 recentCount = 0;
+        u64 recentMemory = 0;                       // The memory's hash & the keys, during those frames
+        u16 recentKeys = 0;
+        u32 period = 0;                             // While idle: the first period entries of recent are the cycle,
+        u32 phase = 0;                              // & the machine is at this one
     };
 }
 
@@ -0,0 +1,97 @@
+#include <cstring>
+#include "cow.hpp"
+
+using namespace ch8::cow;
+
+// C-tors
+
+Runner::Runner(Interface& interface, const char* path)
+    : program(state, interface, path, 0)
+{}
+
+
+// Running
+
+Machine Runner::Start() {
+    Machine machine;
+
+    program.Load();
+    dirty = 0xffff;     // Nothing has been captured yet
+    Leave(machine);
+
+    return machine;
+}
+
+void Runner::Run(Machine& machine, u32 frames) {
+    Enter(machine);
+
+    for (u32 n = 0; n < frames; ++n) {
+        program.RunFrame();
+    }
+
+    state.watchedPages = 0;
+    state.watcher = nullptr;
+
+    Leave(machine);
+}
+
+void Runner::Stored(u16 address, u8, u8) noexcept {
+    dirty |= 1u << (address >> PAGE_SHIFT);
+}
+
+// Only the pages that aren't in memory already are copied in. Pages still dirty (if Leave threw) aren't loaded.
+// The program is told about them, like about any store, so the recompiled code doesn't run over code that changed.
+// Nothing of the previous machine may carry over, so the program forgets what the idle detection saw of it.
+void Runner::Enter(const Machine& machine) noexcept {
+    for (u32 k = 0; k < PAGE_COUNT; ++k) {
+        if ((dirty & (1u << k)) || loaded[k] != machine.pages[k]) {
+            memcpy(&state.memory[k * PAGE_SIZE], machine.pages[k]->data(), PAGE_SIZE);
+            loaded[k] = machine.pages[k];
+            program.Stored(u16(k * PAGE_SIZE), PAGE_SIZE);
+        }
+    }
+
+    state.v = machine.v;
+    state.stack = machine.stack;
+    state.i = machine.i;
+    state.sp = machine.sp;
+    state.pc = machine.pc;
+    state.dt = machine.dt;
+    state.st = machine.st;
+    state.keys = machine.keys;
+    state.seed = machine.seed;
+    state.memoryHash = machine.memoryHash;
+    program.Resume(machine.carried);
+
+    dirty = 0;
+    state.watchedPages = 0xffff;
+    state.watcher = this;
+}
+
+// The pages written to become new pages.
+void Runner::Leave(Machine& machine) {
+    for (u32 k = 0; k < PAGE_COUNT; ++k) {
+        if (dirty & (1u << k)) {
+            auto page = std::make_shared<Page>();
+            memcpy(page->data(), &state.memory[k * PAGE_SIZE], PAGE_SIZE);
+            loaded[k] = std::move(page);
+            ++copied;
+        }
+
+        machine.pages[k] = loaded[k];
+    }
+
+    machine.v = state.v;
+    machine.stack = state.stack;
+    machine.i = state.i;
+    machine.sp = state.sp;
+    machine.pc = state.pc;
+    machine.dt = state.dt;
+    machine.st = state.st;
+    machine.keys = state.keys;
+    machine.seed = state.seed;
+    machine.memoryHash = state.memoryHash;
+    machine.carried = program.Carried();
+
+    dirty = 0;
+}
@@ -0,0 +1,74 @@
+#ifndef GOGA_TAMAS_CHIP_8_COW_HPP
+#define GOGA_TAMAS_CHIP_8_COW_HPP
+
+#include <array>
+#include <memory>
+#include "chip8.hpp"
+
+// Copy-on-write machines, for searches that branch a machine into many futures (say, one per key) over & over.
+// A machine is its registers & 16 pages of memory (256 bytes each, see PAGE_SHIFT), which forks share.
+// Forking copies the registers & the page references. Machines are run by swapping them into a runner's Chip8,
+// where the stores are watched: the pages written to are copied once the machine is swapped out, the rest stay shared.
+
+namespace ch8 {
+    namespace cow {
+        constexpr u32 PAGE_SIZE  = 1u << PAGE_SHIFT;
+        constexpr u32 PAGE_COUNT = MEM_SIZE / PAGE_SIZE;
+
+        using Page = std::array<u8, PAGE_SIZE>;
+
+        struct Machine {
+            std::array<u8, 16>          v;
+            std::array<u16, STACK_SIZE> stack;
+            u16                         i, sp, pc;
+            u8                          dt, st;
+            u16                         keys;       // Held down while it runs
+            u32                         seed;
+            u64                         memoryHash;
+            i32                         carried;    // By the recompiled code, see Program::Carried
+            std::array<std::shared_ptr<const Page>, PAGE_COUNT> pages;
+
+            // Costs the registers & a reference per page.
+            Machine Fork() const {
+                return *this;
+            }
+        };
+
+        // Runs machines on a Chip8 & a Program of its own. Not thread-safe: use a runner per thread.
+        class Runner: Watcher {
+        public:
+            // Check that the ROM loads with a Program first.
+            Runner(Interface& interface, const char* path);
+
+            Runner(const Runner&) = delete;
+            Runner& operator=(const Runner&) = delete;
+
+            // The ROM, freshly loaded.
+            Machine Start();
+
+            // Runs the machine for a number of frames, with its keys held down.
+            // Throws std::bad_alloc if a page can't be copied, the machine is lost then.
+            void Run(Machine& machine, u32 frames);
+
+            // Pages copied because they were written to, so far.
+            u64 Copied() const noexcept {
+                return copied;
+            }
+
+        private:
+            void Stored(u16 address, u8 before, u8 after) noexcept override;
+
+            void Enter(const Machine& machine) noexcept;
+            void Leave(Machine& machine);
+
+            Chip8   state;
+            Program program;
+
+            std::array<std::shared_ptr<const Page>, PAGE_COUNT> loaded;  // What the memory holds, but for dirty pages
+            u16 dirty  = 0;
+            u64 copied = 0;
+        };
+    }
+}
+
+#endif // GOGA_TAMAS_CHIP_8_COW_HPP
@@ -0,0 +1,285 @@
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include "debugger.hpp"
+
+// Trap
+
+// pc has already moved past the breakpoint, so it's moved back, for the debugger to stop on it.
+void ch8::TrapInstruction::Execute() noexcept {
+    state.pc -= 2;
+    stopped = true;
+
+    printf("Breakpoint at %.4x\n", state.pc);
+}
+
+void ch8::TrapInstruction::Disassemble() noexcept {
+    original->Disassemble();
+}
+
+
+// C-tors
+
+ch8::Debugger::Debugger(Program& program, Chip8& state)
+    : program(program)
+    , state(state)
+{
+    state.watcher = this;
+}
+
+ch8::Debugger::~Debugger() {
+    state.watchedPages = 0;
+    state.watcher = nullptr;
+}
+
+
+// Execution
+
+static ch8::TrapInstruction* asTrap(std::unique_ptr<ch8::Instruction>* slot) noexcept {
+    return slot != nullptr ? dynamic_cast<ch8::TrapInstruction*>(slot->get()) : nullptr;
+}
+
+// Self-modifying code may have replaced a trap with the new instruction, so traps are put back before every run.
+void ch8::Debugger::Arm() {
+    for (u16 address: breakpoints) {
+        auto slot = program.Slot(address);
+
+        if (slot != nullptr && asTrap(slot) == nullptr) {
+            *slot = std::make_unique<TrapInstruction>(state, std::move(*slot), stopped);
+        }
+    }
+}
+
+// Steps over a trap at pc by executing the instruction it stands in for.
+void ch8::Debugger::Step() {
+    if (TrapInstruction* trap = asTrap(program.Slot(state.pc))) {
+        state.pc += 2;
+        trap->original->Execute();
+    } else {
+        program.Step();
+    }
+
+    if (++cycles == CYCLES_PER_FRAME) {
+        cycles = 0;
+        state.TickTimers();
+    }
+}
+
+// Runs until a breakpoint or watchpoint is hit, or limit instructions were executed.
+void ch8::Debugger::Continue(u64 limit) {
+    stopped = false;
+    Arm();
+
+    if (limit == 0) {
+        return;
+    }
+
+    Step();
+
+    for (u64 n = 1; n < limit && !stopped; ++n) {
+        const u16 pc = state.pc;
+        program.Step();
+
+        // A trap stops before its instruction, leaving pc where it was, so it isn't counted.
+        // A watchpoint stops after the store, which did execute (& always moves pc on).
+        if (stopped && state.pc == pc) {
+            break;
+        }
+
+        if (++cycles == CYCLES_PER_FRAME) {
+            cycles = 0;
+            state.TickTimers();
+        }
+    }
+}
+
+// Only the exact addresses count, the rest of the page is let through.
+void ch8::Debugger::Stored(u16 address, u8 before, u8 after) noexcept {
+    if (watchpoints[address]) {
+        printf("Watchpoint: [%.3x] %.2x -> %.2x at %.4x\n", address, before, after, state.pc - 2);
+        stopped = true;
+    }
+}
+
+
+// Views
+
+void ch8::Debugger::PrintRegisters() const noexcept {
+    printf("pc %.4x  i %.4x  sp %.2x  dt %.2x  st %.2x  keys %.4x\n", state.pc, state.i, state.sp, state.dt, state.st, state.keys);
+
+    for (u8 x = 0; x < 16; ++x) {
+        printf("v%X %.2x%s", x, state.v[x], x % 8 == 7 ? "\n" : "  ");
+    }
+
+    printf("stack");
+    for (u16 n = 0; n < state.sp; ++n) {
+        printf(" %.4x", state.stack[n]);
+    }
+    putchar('\n');
+}
+
+void ch8::Debugger::PrintMemory(u16 address, u16 length) const noexcept {
+    for (u16 k = 0; k < length; ++k) {
+        if (k % 16 == 0) {
+            printf("%s%.3x: ", k != 0 ? "\n" : "", (address + k) & (MEM_SIZE - 1));
+        }
+
+        printf(" %.2x", state.At(address + k));
+    }
+
+    putchar('\n');
+}
+
+void ch8::Debugger::PrintScreen() const noexcept {
+    for (u16 y = 0; y < SCREEN_HEIGHT; ++y) {
+        for (u16 x = 0; x < SCREEN_WIDTH; ++x) {
+            putchar(state.memory[SCREEN_START + y * SCREEN_WIDTH / 8 + x / 8] & (0x80 >> (x % 8)) ? '#' : '.');
+        }
+
+        putchar('\n');
+    }
+}
+
+// Disassemble prints the address in pc, so pc is borrowed for the listing.
+void ch8::Debugger::List(u16 address, u16 count) {
+    const u16 pc = state.pc;
+
+    for (u16 k = 0; k < count; ++k, address += 2) {
+        auto slot = program.Slot(address);
+
+        printf("%c%c ", breakpoints.count(address) ? '*' : ' ', address == pc ? '>' : ' ');
+        state.pc = address;
+
+        if (slot != nullptr) {
+            (*slot)->Disassemble();
+        } else {
+            printf("%.4x:   <%.2x%.2x>   ; outside of the ROM", address, state.At(address), state.At(address + 1));
+        }
+
+        putchar('\n');
+    }
+
+    state.pc = pc;
+}
+
+
+// Commands
+
+static const char* HELP =
+    "s|step [n]            Executes n instructions (1)\n"
+    "c|continue [n]        Runs until a breakpoint or watchpoint (or n instructions)\n"
+    "f|frame [n]           Runs n frames' worth of instructions (1), stopping at breakpoints\n"
+    "b|break <addr>        Sets a breakpoint\n"
+    "d|delete <addr>       Removes a breakpoint\n"
+    "w|watch <addr> [n]    Stops after stores to n bytes from addr (1)\n"
+    "u|unwatch <addr> [n]  Removes watchpoints\n"
+    "r|regs                Shows the registers\n"
+    "m|mem <addr> [n]      Shows n bytes of memory (64)\n"
+    "l|list [addr] [n]     Disassembles n instructions from addr (pc, 10)\n"
+    "screen                Shows the display\n"
+    "k|keys <mask>         Holds down the keys in mask (bit n is key n)\n"
+    "reset                 Reloads the ROM\n"
+    "q|quit\n";
+
+void ch8::Debugger::Run(std::istream& in) {
+    program.Load();
+
+    const bool interactive = os::IsInteractive();
+    std::string line;
+
+    do {
+        if (interactive) {
+            printf("(chip8 %.4x) ", state.pc);
+            fflush(stdout);
+        }
+    } while (std::getline(in, line) && Command(line));
+}
+
+// Returns false on quit.
+bool ch8::Debugger::Command(const std::string& line) {
+    std::istringstream words(line);
+    std::string command, first, second;
+    words >> command >> first >> second;
+
+    auto number = [](const std::string& word, unsigned long fallback) {
+        return word.empty() ? fallback : strtoul(word.c_str(), nullptr, 0);
+    };
+
+    if (command.empty() || command[0] == '#') {
+        return true;
+    }
+
+    if (command == "q" || command == "quit") {
+        return false;
+    } else if (command == "s" || command == "step") {
+        stopped = false;
+        Arm();
+
+        for (unsigned long n = number(first, 1); n > 0 && !stopped; --n) {
+            Step();
+        }
+
+        List(state.pc, 1);
+    } else if (command == "c" || command == "continue") {
+        Continue(number(first, ~0ul));
+        List(state.pc, 1);
+    } else if (command == "f" || command == "frame") {
+        Continue(number(first, 1) * CYCLES_PER_FRAME - cycles);
+        List(state.pc, 1);
+    } else if (command == "b" || command == "break") {
+        const u16 address = u16(number(first, state.pc));
+
+        if (program.Slot(address) == nullptr) {
+            printf("%.4x: Breakpoints only work on instructions inside the ROM\n", address);
+        } else {
+            breakpoints.insert(address);
+            Arm();
+        }
+    } else if (command == "d" || command == "delete") {
+        const u16 address = u16(number(first, state.pc));
+        auto slot = program.Slot(address);
+
+        if (TrapInstruction* trap = asTrap(slot)) {
+            *slot = std::move(trap->original);
+        }
+
+        breakpoints.erase(address);
+    } else if (command == "w" || command == "watch" || command == "u" || command == "unwatch") {
+        const bool watch = command[0] == 'w';
+        const u16 address = u16(number(first, state.i));
+
+        for (unsigned long k = 0; k < number(second, 1); ++k) {
+            watchpoints[(address + k) & (MEM_SIZE - 1)] = watch;
+        }
+
+        // Pages are watched as long as any of their bytes are.
+        state.watchedPages = 0;
+        for (u16 page = 0; page < MEM_SIZE >> PAGE_SHIFT; ++page) {
+            for (u16 k = page << PAGE_SHIFT; k < (page + 1) << PAGE_SHIFT; ++k) {
+                if (watchpoints[k]) {
+                    state.watchedPages |= 1u << page;
+                    break;
+                }
+            }
+        }
+    } else if (command == "r" || command == "regs") {
+        PrintRegisters();
+    } else if (command == "m" || command == "mem") {
+        PrintMemory(u16(number(first, state.i)), u16(number(second, 64)));
+    } else if (command == "l" || command == "list") {
+        List(u16(number(first, state.pc)), u16(number(second, 10)));
+    } else if (command == "screen") {
+        PrintScreen();
+    } else if (command == "k" || command == "keys") {
+        state.keys = u16(number(first, 0));
+    } else if (command == "reset") {
+        program.Load();
+        cycles = 0;
+    } else if (command == "h" || command == "help") {
+        printf("%s", HELP);
+    } else {
+        printf("Unknown command: %s (try help)\n", command.c_str());
+    }
+
+    return true;
+}
@@ -0,0 +1,67 @@
+#ifndef GOGA_TAMAS_CHIP_8_DEBUGGER_HPP
+#define GOGA_TAMAS_CHIP_8_DEBUGGER_HPP
+
+#include <bitset>
+#include <istream>
+#include <set>
+#include "chip8.hpp"
+
+// Line based debugger, reading its commands from a stream (stdin), so it can be scripted. "help" lists them.
+//
+// Nothing is checked per instruction while running:
+// breakpoints replace the decoded instruction with a trap, which stops the run when it's executed,
+// and watchpoints mark their memory page, so only stores to those pages are looked at.
+// Breakpoints only work inside the ROM, since that's where decoded instructions are kept.
+
+namespace ch8 {
+    // Stands in for the instruction at a breakpoint.
+    class TrapInstruction: public Instruction {
+    public:
+        TrapInstruction(Chip8& s, std::unique_ptr<Instruction> original, bool& stopped)
+            : Instruction(s, original->l, original->r)
+            , original(std::move(original))
+            , stopped(stopped)
+        {}
+
+        void Execute() noexcept override;
+        void Disassemble() noexcept override;
+
+        std::unique_ptr<Instruction> original;
+
+    private:
+        bool& stopped;
+    };
+
+    class Debugger: public Watcher {
+    public:
+        Debugger(Program& program, Chip8& state);
+        ~Debugger();
+
+        // Loads the ROM, then executes commands until the stream ends or "quit".
+        void Run(std::istream& in);
+
+        void Stored(u16 address, u8 before, u8 after) noexcept override;
+
+    private:
+        bool Command(const std::string& line);
+
+        void Arm();
+        void Step();
+        void Continue(u64 limit);
+
+        void PrintRegisters() const noexcept;
+        void PrintMemory(u16 address, u16 length) const noexcept;
+        void PrintScreen() const noexcept;
+        void List(u16 address, u16 count);
+
+        Program& program;
+        Chip8& state;
+
+        bool stopped = false;
+        u32  cycles  = 0;      // Instructions executed since the timers last ticked
+        std::set<u16> breakpoints;
+        std::bitset<MEM_SIZE> watchpoints;
+    };
+}
+
+#endif // GOGA_TAMAS_CHIP_8_DEBUGGER_HPP
@@ -17,9 +17,26 @@ using u64 = uint_least64_t;
 
 namespace ch8 {
     enum PROGRAM_OPTIONS: u32 {
-        OPTIONS_HEX    = 0x1,
-        OPTIONS_CODE   = 0x2,
-        OPTIONS_NOEXEC = 0x4
+        OPTIONS_HEX      = 0x1,
+        OPTIONS_CODE     = 0x2,
+        OPTIONS_NOEXEC   = 0x4,
+        OPTIONS_AOT      = 0x8,
+        OPTIONS_PHOSPHOR = 0x10,
+        OPTIONS_TURBO    = 0x20,
+        OPTIONS_RECORD   = 0x40,
+        OPTIONS_VERIFY   = 0x80,
+        OPTIONS_TRACE    = 0x100,
+        OPTIONS_COMPRESS = 0x200,
+        OPTIONS_DEBUG    = 0x400,
+        OPTIONS_EXPORT   = 0x800,
+        OPTIONS_CHANGED  = 0x1000,
+        OPTIONS_SERVE    = 0x2000,
+        OPTIONS_PUBLISH  = 0x4000,
+        OPTIONS_TILES    = 0x8000,
+        OPTIONS_STARTUP  = 0x10000,
+        OPTIONS_OPTIMIZE = 0x40000,
+        OPTIONS_TERMINAL = 0x80000,
+        OPTIONS_LATENCY  = 0x100000
     };
 
     constexpr u16 MEM_START    = 0x200;
@@ -27,6 +44,14 @@ namespace ch8 {
     constexpr u16 SCREEN_START = 0xf00;
     constexpr u16 STACK_SIZE   = 0x10;
     constexpr u16 MAX_PROG_LEN = MEM_SIZE - MEM_START - (MEM_SIZE - SCREEN_START);
+    constexpr u16 FONT_START   = 0x000;
+
+    constexpr u16 SCREEN_WIDTH  = 64;
+    constexpr u16 SCREEN_HEIGHT = 32;
+
+    // Timing: the timers tick at 60 Hz, and the CPU executes a fixed amount of instructions between ticks.
+    constexpr u32 FRAME_RATE       = 60;
+    constexpr u32 CYCLES_PER_FRAME = 10;
 }
 
 #endif // GOGA_TAMAS_CHIP_8_DEFINES_HPP
\ No newline at end of file
@@ -0,0 +1,134 @@
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include "export.hpp"
+
+static constexpr u32 ROW_BYTES = ch8::SCREEN_WIDTH / 8;
+
+// 8 pixels for each display byte, one byte each (Y4M) or three (PPM). Lit pixels are white.
+struct Tables {
+    u8 luma[256][8];
+    u8 rgb[256][24];
+
+    Tables() noexcept {
+        for (u32 byte = 0; byte < 256; ++byte) {
+            for (u32 bit = 0; bit < 8; ++bit) {
+                const u8 value = byte & (0x80 >> bit) ? 0xff : 0x00;
+
+                luma[byte][bit] = value;
+                memset(&rgb[byte][bit * 3], value, 3);
+            }
+        }
+    }
+};
+
+static const Tables& tables() noexcept {
+    static const Tables built;
+    return built;
+}
+
+
+// C-tors
+
+ch8::Exporter::Exporter(EXPORT_FORMAT format, const std::string& path, bool changedOnly)
+    : format(format)
+    , path(path)
+    , changedOnly(changedOnly)
+{
+    if (format != EXPORT_Y4M) {
+        return;
+    }
+
+    stream = path == "-" ? stdout : fopen(path.c_str(), "wb");
+
+    if (stream == nullptr) {
+        throw std::runtime_error(path + ": " + strerror(errno));
+    }
+
+    setvbuf(stream, nullptr, _IOFBF, 1u << 20);
+    fprintf(stream, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 Cmono\n", SCREEN_WIDTH, SCREEN_HEIGHT, FRAME_RATE);
+}
+
+ch8::Exporter::~Exporter() {
+    if (stream == stdout) {
+        fflush(stream);
+    } else if (stream != nullptr) {
+        fclose(stream);
+    }
+}
+
+
+// Writing
+
+bool ch8::Exporter::Write(const u8* screen) {
+    const u32 number = frame++;
+
+    if (changedOnly && !first && memcmp(last.data(), screen, SCREEN_BYTES) == 0) {
+        return true;
+    }
+
+    first = false;
+    memcpy(last.data(), screen, SCREEN_BYTES);
+
+    if (stream != nullptr) {
+        return WriteFrame(stream, screen);
+    }
+
+    char name[16];
+    snprintf(name, sizeof(name), "%.6u.%s", number, format == EXPORT_PBM ? "pbm" : "ppm");
+
+    FILE* file = fopen((path + name).c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    const bool ok = WriteFrame(file, screen);
+    return fclose(file) == 0 && ok;
+}
+
+// One row at a time, so the only buffer is a row of pixels.
+bool ch8::Exporter::WriteFrame(FILE* file, const u8* screen) noexcept {
+    const Tables& table = tables();
+    u8 row[SCREEN_WIDTH * 3];
+
+    switch (format) {
+    case EXPORT_Y4M:
+        fputs("FRAME\n", file);
+
+        for (u32 y = 0; y < SCREEN_HEIGHT; ++y) {
+            for (u32 b = 0; b < ROW_BYTES; ++b) {
+                memcpy(&row[b * 8], table.luma[screen[y * ROW_BYTES + b]], 8);
+            }
+
+            fwrite(row, 1, SCREEN_WIDTH, file);
+        }
+        break;
+
+    case EXPORT_PBM:
+        fprintf(file, "P4\n%u %u\n", SCREEN_WIDTH, SCREEN_HEIGHT);
+
+        for (u32 y = 0; y < SCREEN_HEIGHT; ++y) {
+            for (u32 b = 0; b < ROW_BYTES; ++b) {
+                row[b] = ~screen[y * ROW_BYTES + b];
+            }
+
+            fwrite(row, 1, ROW_BYTES, file);
+        }
+        break;
+
+    case EXPORT_PPM:
+        fprintf(file, "P6\n%u %u\n255\n", SCREEN_WIDTH, SCREEN_HEIGHT);
+
+        for (u32 y = 0; y < SCREEN_HEIGHT; ++y) {
+            for (u32 b = 0; b < ROW_BYTES; ++b) {
+                memcpy(&row[b * 24], table.rgb[screen[y * ROW_BYTES + b]], 24);
+            }
+
+            fwrite(row, 1, sizeof(row), file);
+        }
+        break;
+    }
+
+    ++written;
+    return !ferror(file);
+}
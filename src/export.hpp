@@ -0,0 +1,55 @@
+#ifndef GOGA_TAMAS_CHIP_8_EXPORT_HPP
+#define GOGA_TAMAS_CHIP_8_EXPORT_HPP
+
+#include <array>
+#include <cstdio>
+#include <string>
+#include "defines.hpp"
+
+// Headless frame export, straight from the bit-packed display:
+// Y4M: one 64x32 greyscale (Cmono) stream at 60 fps, into a file or a pipe ("-" is stdout).
+// PBM & PPM: one binary (P4 / P6) file per frame, named <prefix><frame number>.pbm / .ppm.
+// PBM rows are the display's rows, inverted (1 is black in PBM). Y4M & PPM expand each byte through a table.
+
+namespace ch8 {
+    enum EXPORT_FORMAT: u32 {
+        EXPORT_Y4M,
+        EXPORT_PBM,
+        EXPORT_PPM
+    };
+
+    class Exporter {
+    public:
+        // Throws if the Y4M stream can't be opened.
+        Exporter(EXPORT_FORMAT format, const std::string& path, bool changedOnly);
+        ~Exporter();
+
+        Exporter(const Exporter&) = delete;
+        Exporter& operator=(const Exporter&) = delete;
+
+        // Writes a frame, unless only changes are exported & it's the same as the last one written.
+        // Returns false if the frame couldn't be written.
+        bool Write(const u8* screen);
+
+        u32 Written() const noexcept {
+            return written;
+        }
+
+    private:
+        static constexpr u32 SCREEN_BYTES = SCREEN_WIDTH * SCREEN_HEIGHT / 8;
+
+        bool WriteFrame(FILE* file, const u8* screen) noexcept;
+
+        EXPORT_FORMAT format;
+        std::string   path;
+        bool          changedOnly;
+
+        FILE* stream = nullptr;     // Y4M only
+        u32   frame  = 0;
+        u32   written = 0;
+        bool  first  = true;
+        std::array<u8, SCREEN_BYTES> last;
+    };
+}
+
+#endif // GOGA_TAMAS_CHIP_8_EXPORT_HPP
@@ -0,0 +1,68 @@
+#include "flow.hpp"
+
+using namespace ch8::flow;
+
+Analysis::Analysis(const std::vector<u8>& rom)
+    : opcodes(rom.size() / 2)
+    , flags(rom.size() / 2, 0)
+{
+    const u32 words = u32(rom.size() / 2);
+    std::vector<u32> work = {0};
+
+    for (u32 k = 0; k < words; ++k) {
+        opcodes[k] = ch8::Classify(rom[k * 2], rom[k * 2 + 1]);
+    }
+
+    auto land = [&](u16 address) {
+        if (address % 2 == 0 && address >= ch8::MEM_START && u32(address - ch8::MEM_START) / 2 < words) {
+            const u32 word = (address - ch8::MEM_START) / 2;
+
+            flags[word] |= FLAG_LEADER;
+            work.push_back(word);
+        }
+    };
+
+    if (words > 0) {
+        flags[0] |= FLAG_LEADER;
+    }
+
+    while (!work.empty()) {
+        u32 word = work.back();
+        work.pop_back();
+
+        for (; word < words && !(flags[word] & FLAG_CODE); ++word) {
+            const u16 address = ch8::MEM_START + word * 2;
+            const u16 target = ((u16(rom[word * 2]) & 0x00f) << 8) | rom[word * 2 + 1];
+
+            flags[word] |= FLAG_CODE;
+
+            switch (opcodes[word]) {
+            case ch8::OP_CALL:
+                land(target);
+                continue;
+
+            case ch8::OP_SE:
+            case ch8::OP_SNE:
+            case ch8::OP_SE_V:
+            case ch8::OP_SNE_V:
+            case ch8::OP_SKP:
+            case ch8::OP_SKNP:
+                land(address + 4);
+                continue;
+
+            case ch8::OP_JP:
+                land(target);
+                break;
+
+            case ch8::OP_RET:
+            case ch8::OP_JP_V0:
+                break;
+
+            default:
+                continue;
+            }
+
+            break;
+        }
+    }
+}
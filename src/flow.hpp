@@ -0,0 +1,27 @@
+#ifndef GOGA_TAMAS_CHIP_8_FLOW_HPP
+#define GOGA_TAMAS_CHIP_8_FLOW_HPP
+
+#include <vector>
+#include "instructions.hpp"
+
+// Static control flow of a ROM: the opcode of every word, and which words are reachable code
+// (& which of those start a basic block). Followed from the entry point, Bnnn & anything outside the ROM end a path.
+
+namespace ch8 {
+    namespace flow {
+        enum FLAGS: u8 {
+            FLAG_CODE   = 0x1,  // Reachable from the entry point
+            FLAG_LEADER = 0x2   // Control flow lands here, other than by falling through
+        };
+
+        // One of each per word of the ROM.
+        struct Analysis {
+            std::vector<u8> opcodes;
+            std::vector<u8> flags;
+
+            explicit Analysis(const std::vector<u8>& rom);
+        };
+    }
+}
+
+#endif // GOGA_TAMAS_CHIP_8_FLOW_HPP
@@ -0,0 +1,90 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include "golden.hpp"
+
+static constexpr char MAGIC[8]   = {'C', 'H', '8', 'G', 'O', 'L', 'D', '\0'};
+static constexpr u32  VERSION    = 1;
+static constexpr u32  HEADER_LEN = 32;
+
+static void put(std::vector<char>& out, u64 value, u32 bytes) {
+    for (u32 k = 0; k < bytes; ++k, value >>= 8) {
+        out.push_back(char(value & 0xff));
+    }
+}
+
+static u64 get(const char* in, u32 bytes) noexcept {
+    u64 value = 0;
+
+    for (u32 k = bytes; k > 0; --k) {
+        value = value << 8 | u8(in[k - 1]);
+    }
+
+    return value;
+}
+
+bool ch8::GoldenTrace::Read(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+
+    if (!file.is_open()) {
+        error = path + ": " + strerror(errno);
+        return false;
+    }
+
+    auto bytes = std::vector<char>(std::istreambuf_iterator<char>(file), {});
+
+    if (bytes.size() < HEADER_LEN || !std::equal(std::begin(MAGIC), std::end(MAGIC), bytes.begin())) {
+        error = path + ": Not a golden trace";
+        return false;
+    }
+
+    if (get(&bytes[8], 4) != VERSION) {
+        error = path + ": Unknown golden trace version " + std::to_string(get(&bytes[8], 4));
+        return false;
+    }
+
+    const u64 count = get(&bytes[24], 8);
+
+    if (count != (bytes.size() - HEADER_LEN) / 8) {
+        error = path + ": Truncated golden trace";
+        return false;
+    }
+
+    cycles = u32(get(&bytes[12], 4));
+    rom    = get(&bytes[16], 8);
+    frames.resize(count);
+
+    for (u64 k = 0; k < count; ++k) {
+        frames[k] = get(&bytes[HEADER_LEN + k * 8], 8);
+    }
+
+    error.clear();
+    return true;
+}
+
+bool ch8::GoldenTrace::Write(const std::string& path) {
+    std::vector<char> bytes(std::begin(MAGIC), std::end(MAGIC));
+    bytes.reserve(HEADER_LEN + frames.size() * 8);
+
+    put(bytes, VERSION, 4);
+    put(bytes, cycles, 4);
+    put(bytes, rom, 8);
+    put(bytes, frames.size(), 8);
+
+    for (u64 hash: frames) {
+        put(bytes, hash, 8);
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(bytes.data(), bytes.size());
+
+    if (!file) {
+        error = path + ": " + strerror(errno);
+        return false;
+    }
+
+    error.clear();
+    return true;
+}
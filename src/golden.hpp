@@ -0,0 +1,33 @@
+#ifndef GOGA_TAMAS_CHIP_8_GOLDEN_HPP
+#define GOGA_TAMAS_CHIP_8_GOLDEN_HPP
+
+#include <string>
+#include <vector>
+#include "defines.hpp"
+
+// Golden traces: the machine's hash (see Chip8::Hash) after every frame of a headless run.
+// A build is checked by running the same ROM again, and comparing the hashes frame by frame.
+//
+// File layout, all little-endian:
+// 0:  "CH8GOLD\0"
+// 8:  u32 version (1)
+// 12: u32 CYCLES_PER_FRAME of the build that wrote it
+// 16: u64 hash of the ROM
+// 24: u64 frame count
+// 32: u64 hash of each frame
+
+namespace ch8 {
+    struct GoldenTrace {
+        u32              cycles = CYCLES_PER_FRAME;
+        u64              rom    = 0;
+        std::vector<u64> frames;
+
+        // Both return false (and leave a message in error) if the file couldn't be read or written.
+        bool Read(const std::string& path);
+        bool Write(const std::string& path);
+
+        std::string error;
+    };
+}
+
+#endif // GOGA_TAMAS_CHIP_8_GOLDEN_HPP
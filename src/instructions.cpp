@@ -1,293 +1,393 @@
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
 #include "instructions.hpp"
 
-// Base
+// Allocation
 
-void ch8::Instruction::PrintInstruction(const char* name) const noexcept {
-    printf("%.4x:   <%.2x%.2x>   %-8s ", state.pc, l, r, name);
+void* ch8::CacheAligned::operator new(std::size_t size) {
+    void* pointer = nullptr;
+
+    if (posix_memalign(&pointer, CACHE_LINE, size) != 0) {
+        throw std::bad_alloc();
+    }
+
+    return pointer;
 }
 
-void ch8::Instruction::Execute() noexcept {
-    // printf("<pc = %.4x> Ignored instruction, nothing executed.\n", this->state.pc);
+void ch8::CacheAligned::operator delete(void* pointer) noexcept {
+    free(pointer);
 }
 
-void ch8::Instruction::Disassemble() noexcept {
-    PrintInstruction("; ignored");
+
+// CPU
+
+static const std::array<u8, 80> font = {{
+    0xf0, 0x90, 0x90, 0x90, 0xf0, // 0
+    0x20, 0x60, 0x20, 0x20, 0x70, // 1
+    0xf0, 0x10, 0xf0, 0x80, 0xf0, // 2
+    0xf0, 0x10, 0xf0, 0x10, 0xf0, // 3
+    0x90, 0x90, 0xf0, 0x10, 0x10, // 4
+    0xf0, 0x80, 0xf0, 0x10, 0xf0, // 5
+    0xf0, 0x80, 0xf0, 0x90, 0xf0, // 6
+    0xf0, 0x10, 0x20, 0x40, 0x40, // 7
+    0xf0, 0x90, 0xf0, 0x90, 0xf0, // 8
+    0xf0, 0x90, 0xf0, 0x10, 0xf0, // 9
+    0xf0, 0x90, 0xf0, 0x90, 0x90, // A
+    0xe0, 0x90, 0xe0, 0x90, 0xe0, // B
+    0xf0, 0x80, 0x80, 0x80, 0xf0, // C
+    0xe0, 0x90, 0x90, 0x90, 0xe0, // D
+    0xf0, 0x80, 0xf0, 0x80, 0xf0, // E
+    0xf0, 0x80, 0xf0, 0x80, 0x80  // F
+}};
+
+void ch8::Chip8::Reset() noexcept {
+    v.fill(0);
+    stack.fill(0);
+    i = 0;
+    sp = 0;
+    pc = MEM_START;
+    dt = 0;
+    st = 0;
+    keys = 0;
+    keysRead = 0;
+    seed = 0x2545f491u;
+
+    for (u16 k = 0; k < font.size(); ++k) {
+        Store(FONT_START + k, font[k]);
+    }
+
+    ClearScreen();
 }
 
+void ch8::Chip8::ClearScreen() noexcept {
+    const bool watched = watchedPages & (1u << (SCREEN_START >> PAGE_SHIFT));
 
-// 00e0: Clear screen.
+    for (u16 address = SCREEN_START; address < MEM_SIZE; ++address) {
+        memoryHash ^= HashCell(address, memory[address]);
 
-void ch8::ClearScreenInstruction::Execute() noexcept {
-    interface.ClearScreen();
+        if (watched && memory[address] != 0) {
+            watcher->Stored(address, memory[address], 0);
+        }
+    }
+
+    std::fill(memory.begin() + SCREEN_START, memory.end(), 0);
 }
 
-void ch8::ClearScreenInstruction::Disassemble() noexcept {
-    PrintInstruction("CLS");
+void ch8::Chip8::Rehash() noexcept {
+    memoryHash = 0;
+
+    for (u16 address = 0; address < MEM_SIZE; ++address) {
+        memoryHash ^= HashCell(address, memory[address]);
+    }
 }
 
+// FNV-1a, on top of the memory's hash.
+u64 ch8::Chip8::Hash() const noexcept {
+    u64 hash = 0xcbf29ce484222325ull ^ memoryHash;
 
-// 00ee: Return.
+    auto add = [&hash](u64 value, u32 bytes) {
+        for (u32 k = 0; k < bytes; ++k, value >>= 8) {
+            hash = (hash ^ (value & 0xff)) * 0x100000001b3ull;
+        }
+    };
+
+    for (u8 x: v) {
+        add(x, 1);
+    }
+
+    for (u16 address: stack) {
+        add(address, 2);
+    }
 
-void ch8::ReturnInstruction::Execute() noexcept {}
+    add(i, 2);
+    add(sp, 2);
+    add(pc, 2);
+    add(dt, 1);
+    add(st, 1);
+    add(seed, 4);
 
-void ch8::ReturnInstruction::Disassemble() noexcept {
-    PrintInstruction("RET");
+    return hash;
 }
 
+u8 ch8::Chip8::Draw(u8 x, u8 y, u8 n) noexcept {
+    constexpr u16 ROW_BYTES = SCREEN_WIDTH / 8;
 
-// 1nnn: goto nnn; Jumps to address nnn.
+    x %= SCREEN_WIDTH;
+    y %= SCREEN_HEIGHT;
 
-void ch8::JumpInstruction::Execute() noexcept {}
+    const u8 shift = x % 8;
+    const u16 column = x / 8;
+    u8 collision = 0;
 
-void ch8::JumpInstruction::Disassemble() noexcept {
-    u16 nnn = Get16BitAddress();
+    const bool watched = watchedPages & (1u << (SCREEN_START >> PAGE_SHIFT));
 
-    PrintInstruction("JMP");
-    printf("%X", nnn);
-}
+    // Every byte that's XORed into the screen is XORed out of & back into the memory's hash.
+    auto blit = [this, watched, &collision](u16 address, u8 bits) {
+        u8& cell = memory[address];
 
+        if (watched && bits != 0) {
+            watcher->Stored(address, cell, cell ^ bits);
+        }
 
-// 2nnn: *(nnn)(); Calls subroutine at nnn.
+        collision |= cell & bits;
+        memoryHash ^= HashCell(address, cell) ^ HashCell(address, cell ^ bits);
+        cell ^= bits;
+    };
 
-void ch8::CallInstruction::Execute() noexcept {}
+    for (u8 row = 0; row < n && y + row < SCREEN_HEIGHT; ++row) {
+        u8 sprite = At(i + row);
+        u16 address = SCREEN_START + (y + row) * ROW_BYTES + column;
 
-void ch8::CallInstruction::Disassemble() noexcept {
-    u16 nnn = Get16BitAddress();
+        if (sprite == 0) {
+            continue;
+        }
 
-    PrintInstruction("CALL");
-    printf("%X", nnn);
-}
+        blit(address, sprite >> shift);
 
+        if (shift != 0 && column + 1 < ROW_BYTES) {
+            blit(address + 1, u8(sprite << (8 - shift)));
+        }
+    }
 
-// 3xnn: if(Vx == nn); Skips the next instruction if Vx equals nn.
-// Usually the next instruction is a jump to skip a code block. Applies for 4, 5 & 9, too.
+    return collision != 0;
+}
 
-void ch8::SkipEqualInstruction::Execute() noexcept {}
 
-void ch8::SkipEqualInstruction::Disassemble() noexcept {
-    u8 vx = GetRightNibble(l);
-    i8 nn = r;
+// Base
 
-    PrintInstruction("SE");
-    printf("V%X, %d", vx, nn);
+void ch8::Instruction::PrintInstruction(const char* name) const noexcept {
+    printf("%.4x:   <%.2x%.2x>   %-8s ", state.pc, l, r, name);
 }
 
+void ch8::Instruction::Execute() noexcept {
+    // printf("<pc = %.4x> Ignored instruction, nothing executed.\n", this->state.pc);
+}
 
-// 4xnn: if(Vx != nn); Skips the next instruction if Vx doesn't equal nn.
+// The operands are filled into the pattern's placeholders, see opcodes.hpp.
+void ch8::Instruction::Disassemble() noexcept {
+    const Pattern& pattern = PATTERNS[Classify(l, r)];
 
-void ch8::SkipNotEqualInstruction::Execute() noexcept {}
+    PrintInstruction(pattern.mnemonic);
 
-void ch8::SkipNotEqualInstruction::Disassemble() noexcept {
-    u8 vx = GetRightNibble(l);
-    i8 nn = r;
+    for (const char* c = pattern.operands; *c != '\0'; ++c) {
+        if (*c != '{') {
+            putchar(*c);
+            continue;
+        }
 
-    PrintInstruction("SNE");
-    printf("V%X, %d", vx, nn);
-}
+        const char* end = strchr(c, '}');
+        auto is = [c, end](const char* placeholder) {
+            return std::size_t(end - c - 1) == strlen(placeholder) && strncmp(c + 1, placeholder, end - c - 1) == 0;
+        };
 
+        if (is("x")) {
+            printf("%X", GetRightNibble(l));
+        } else if (is("y")) {
+            printf("%X", GetLeftNibble(r));
+        } else if (is("nnn")) {
+            printf("%X", Get16BitAddress());
+        } else if (is("nn")) {
+            printf("%d", i8(r));
+        } else if (is("kk")) {
+            printf("%u", r);
+        } else if (is("n")) {
+            printf("%.2u", GetRightNibble(r));
+        }
 
-// 5xy0: if(Vx == Vy); Skips the next instruction if Vx equals Vy.
+        c = end;
+    }
+}
 
-void ch8::SkipRegisterEqualInstruction::Execute() noexcept {}
 
-void ch8::SkipRegisterEqualInstruction::Disassemble() noexcept {
-    u8 vx = GetRightNibble(l);
-    u8 vy= GetLeftNibble(r);
+// 00e0: Clear screen.
 
-    PrintInstruction("SRE");
-    printf("V%X, V%X", vx, vy);
+void ch8::ClearScreenInstruction::Execute() noexcept {
+    state.ClearScreen();
 }
 
 
-// 6xnn: Vx = nn; Sets VX to NN.
+// 00ee: Return.
+
+void ch8::ReturnInstruction::Execute() noexcept {
+    if (state.sp > 0) {
+        state.pc = state.stack[--state.sp];
+    }
+}
 
-void ch8::MoveInstruction::Execute() noexcept {}
 
-void ch8::MoveInstruction::Disassemble() noexcept {
-    u8 vx = GetRightNibble(l);
-    i8 nn = r;
+// 1nnn: goto nnn; Jumps to address nnn.
 
-    PrintInstruction("MOV");
-    printf("V%X, %d", vx, nn);
+void ch8::JumpInstruction::Execute() noexcept {
+    state.pc = Get16BitAddress();
 }
 
 
-// 7xnn: Vx += nn; Adds nn to Vx. (Carry flag is not changed.)
+// 2nnn: *(nnn)(); Calls subroutine at nnn.
+
+void ch8::CallInstruction::Execute() noexcept {
+    // A full stack drops the call, rather than writing past the end of it.
+    if (state.sp < STACK_SIZE) {
+        state.stack[state.sp++] = state.pc;
+        state.pc = Get16BitAddress();
+    }
+}
 
-void ch8::AddInstruction::Execute() noexcept {}
 
-void ch8::AddInstruction::Disassemble() noexcept {
-    u8 vx = GetRightNibble(l);
-    i8 nn = r;
+// 3xnn: if(Vx == nn); Skips the next instruction if Vx equals nn.
+// Usually the next instruction is a jump to skip a code block. Applies for 4, 5 & 9, too.
 
-    PrintInstruction("ADD");
-    printf("V%X, %d", vx, nn);
+void ch8::SkipEqualInstruction::Execute() noexcept {
+    if (state.v[GetRightNibble(l)] == r) {
+        state.pc += 2;
+    }
 }
 
 
-// 8xy0: Vx = Vy; Sets Vx to the value of Vy.
+// 4xnn: if(Vx != nn); Skips the next instruction if Vx doesn't equal nn.
 
-void ch8::MoveRegisterInstruction::Execute() noexcept {}
+void ch8::SkipNotEqualInstruction::Execute() noexcept {
+    if (state.v[GetRightNibble(l)] != r) {
+        state.pc += 2;
+    }
+}
 
-void ch8::MoveRegisterInstruction::Disassemble() noexcept {
-    u8 vx = GetRightNibble(l);
-    u8 vy = GetLeftNibble(r);
 
-    PrintInstruction("MOVR");
-    printf("V%X, V%X", vx, vy);
+// 5xy0: if(Vx == Vy); Skips the next instruction if Vx equals Vy.
+
+void ch8::SkipRegisterEqualInstruction::Execute() noexcept {
+    if (state.v[GetRightNibble(l)] == state.v[GetLeftNibble(r)]) {
+        state.pc += 2;
+    }
 }
 
 
-// 8xy1: Vx |= Vy; Sets Vx to Vx or Vy. (Bitwise OR operation)
+// 6xnn: Vx = nn; Sets VX to NN.
+
+void ch8::MoveInstruction::Execute() noexcept {
+    state.v[GetRightNibble(l)] = r;
+}
 
-void ch8::OrInstruction::Execute() noexcept {}
 
-void ch8::OrInstruction::Disassemble() noexcept {
-    u8 vx = GetRightNibble(l);
-    u8 vy = GetLeftNibble(r);
+// 7xnn: Vx += nn; Adds nn to Vx. (Carry flag is not changed.)
 
-    PrintInstruction("OR");
-    printf("V%X, V%X", vx, vy);
+void ch8::AddInstruction::Execute() noexcept {
+    state.v[GetRightNibble(l)] += r;
 }
 
 
-// 8xy2: Vx &= Vy; Sets Vx to Vx and Vy. (Bitwise AND operation)
+// 8xy0: Vx = Vy; Sets Vx to the value of Vy.
+
+void ch8::MoveRegisterInstruction::Execute() noexcept {
+    state.v[GetRightNibble(l)] = state.v[GetLeftNibble(r)];
+}
 
-void ch8::AndInstruction::Execute() noexcept {}
 
-void ch8::AndInstruction::Disassemble() noexcept {
-    u8 vx = GetRightNibble(l);
-    u8 vy = GetLeftNibble(r);
+// 8xy1: Vx |= Vy; Sets Vx to Vx or Vy. (Bitwise OR operation)
 
-    PrintInstruction("AND");
-    printf("V%X, V%X", vx, vy);
+void ch8::OrInstruction::Execute() noexcept {
+    state.v[GetRightNibble(l)] |= state.v[GetLeftNibble(r)];
 }
 
 
-// 8xy3: Vx ^= Vy; Sets Vx to Vx xor Vy.
+// 8xy2: Vx &= Vy; Sets Vx to Vx and Vy. (Bitwise AND operation)
+
+void ch8::AndInstruction::Execute() noexcept {
+    state.v[GetRightNibble(l)] &= state.v[GetLeftNibble(r)];
+}
 
-void ch8::XorInstruction::Execute() noexcept {}
 
-void ch8::XorInstruction::Disassemble() noexcept {
-    u8 vx = GetRightNibble(l);
-    u8 vy = GetLeftNibble(r);
+// 8xy3: Vx ^= Vy; Sets Vx to Vx xor Vy.
 
-    PrintInstruction("XOR");
-    printf("V%X, V%X", vx, vy);
+void ch8::XorInstruction::Execute() noexcept {
+    state.v[GetRightNibble(l)] ^= state.v[GetLeftNibble(r)];
 }
 
 
 // 8xy4: Vx += Vy; Adds Vxy to Vy. Vf is set to 1 when there's a carry, and to 0 when there isn't.
 
-void ch8::AddRegisterInstruction::Execute() noexcept {}
+void ch8::AddRegisterInstruction::Execute() noexcept {
+    u16 sum = state.v[GetRightNibble(l)] + state.v[GetLeftNibble(r)];
 
-void ch8::AddRegisterInstruction::Disassemble() noexcept {
-    u8 vx = GetRightNibble(l);
-    u8 vy = GetLeftNibble(r);
-
-    PrintInstruction("ADDR");
-    printf("V%X, V%X", vx, vy);
+    state.v[GetRightNibble(l)] = u8(sum);
+    state.v[0xf] = sum > 0xff;
 }
 
 
 // 8xy5: Vx -= Vy; Vy is subtracted from Vx. Vf is set to 0 when there's a borrow, and 1 when there isn't.
 
-void ch8::SubInstruction::Execute() noexcept {}
-
-void ch8::SubInstruction::Disassemble() noexcept {
-    u8 vx = GetRightNibble(l);
-    u8 vy = GetLeftNibble(r);
+void ch8::SubInstruction::Execute() noexcept {
+    u8& vx = state.v[GetRightNibble(l)];
+    u8 vy = state.v[GetLeftNibble(r)];
+    u8 flag = vx >= vy;
 
-    PrintInstruction("SUB");
-    printf("V%X, V%X", vx, vy);
+    vx -= vy;
+    state.v[0xf] = flag;
 }
 
 
 // 8xy6: Vx >>= 1; Stores the least significant bit of Vx in Vf and then shifts Vx to the right by 1.
 
-void ch8::ShiftRightInstruction::Execute() noexcept {}
-
-void ch8::ShiftRightInstruction::Disassemble() noexcept {
-    u8 vx = GetRightNibble(l);
+void ch8::ShiftRightInstruction::Execute() noexcept {
+    u8& vx = state.v[GetRightNibble(l)];
+    u8 flag = vx & 0x1;
 
-    PrintInstruction("SHR");
-    printf("V%X", vx);
+    vx >>= 1;
+    state.v[0xf] = flag;
 }
 
 
 // 8xy7: Vx = Vy - Vx; Sets Vx to Vy minus Vx. Vf is set to 0 when there's a borrow, and 1 when there isn't.
 
-void ch8::SubInverseInstruction::Execute() noexcept {}
+void ch8::SubInverseInstruction::Execute() noexcept {
+    u8& vx = state.v[GetRightNibble(l)];
+    u8 vy = state.v[GetLeftNibble(r)];
+    u8 flag = vy >= vx;
 
-void ch8::SubInverseInstruction::Disassemble() noexcept {
-    u8 vx = GetRightNibble(l);
-    u8 vy = GetLeftNibble(r);
-
-    PrintInstruction("SUBINV");
-    printf("V%X, V%X", vx, vy);
+    vx = vy - vx;
+    state.v[0xf] = flag;
 }
 
 
 // 8xyE: Vx <<= 1; Stores the most significant bit of Vx in Vf and then shifts Vx to the left by 1.
 
-void ch8::ShiftLeftInstruction::Execute() noexcept {}
-
-void ch8::ShiftLeftInstruction::Disassemble() noexcept {
-    u8 vx = GetRightNibble(l);
+void ch8::ShiftLeftInstruction::Execute() noexcept {
+    u8& vx = state.v[GetRightNibble(l)];
+    u8 flag = vx >> 7;
 
-    PrintInstruction("SHL");
-    printf("V%X", vx);
+    vx <<= 1;
+    state.v[0xf] = flag;
 }
 
 
 // 9xy0: if(Vx != Vy); Skips the next instruction if Vx doesn't equal Vy.
 
-void ch8::SkipRegisterNotEqualInstruction::Execute() noexcept {}
-
-void ch8::SkipRegisterNotEqualInstruction::Disassemble() noexcept {
-    u8 vx = GetRightNibble(l);
-    u8 vy = GetLeftNibble(r);
-
-    PrintInstruction("SRNE");
-    printf("V%X, V%X", vx, vy);
+void ch8::SkipRegisterNotEqualInstruction::Execute() noexcept {
+    if (state.v[GetRightNibble(l)] != state.v[GetLeftNibble(r)]) {
+        state.pc += 2;
+    }
 }
 
 
 // Annn: i = nnn; Sets i to the address nnn.
 
-void ch8::MoveAddressInstruction::Execute() noexcept {}
-
-void ch8::MoveAddressInstruction::Disassemble() noexcept {
-    u16 nnn = Get16BitAddress();
-
-    PrintInstruction("MOVI");
-    printf("%X", nnn);
+void ch8::MoveAddressInstruction::Execute() noexcept {
+    state.i = Get16BitAddress();
 }
 
 
 // Bnnn: PC = V0 + nnn; Jumps to the address nnn plus V0.
 
-void ch8::JumpRegisterInstruction::Execute() noexcept {}
-
-void ch8::JumpRegisterInstruction::Disassemble() noexcept {
-    i16 nnn = Get16BitAddress();
-
-    PrintInstruction("JMPV");
-    printf("%X", nnn);
+void ch8::JumpRegisterInstruction::Execute() noexcept {
+    state.pc = Get16BitAddress() + state.v[0];
 }
 
 
 // Cxnn: Vx = rand() & nn; Sets Vx to the result of a bitwise and operation on a random number (Typically: 0 to 255) and nn.
 
-void ch8::RandomMaskInstruction::Execute() noexcept {}
-
-void ch8::RandomMaskInstruction::Disassemble() noexcept {
-    u8 vx = GetRightNibble(l);
-    u8 nn = r;
-
-    PrintInstruction("RNDMSK");
-    printf("V%X, V%u", vx, nn);
+void ch8::RandomMaskInstruction::Execute() noexcept {
+    state.v[GetRightNibble(l)] = state.Random() & r;
 }
 
 
@@ -296,112 +396,93 @@ void ch8::RandomMaskInstruction::Disassemble() noexcept {
 // As described above, Vf is set to 1 if any screen pixels are flipped from set to unset when the sprite is drawn,
 // and to 0 if that doesn’t happen.
 
-void ch8::DrawInstruction::Execute() noexcept {}
+void ch8::DrawInstruction::Execute() noexcept {
+    u8 vx = state.v[GetRightNibble(l)];
+    u8 vy = state.v[GetLeftNibble(r)];
 
-void ch8::DrawInstruction::Disassemble() noexcept {
-    u8 vx = GetRightNibble(l);
-    u8 vy = GetLeftNibble(r);
-    u8 n = GetRightNibble(r);
-
-    PrintInstruction("DRAW");
-    printf("V%X, V%X, %.2u", vx, vy, n);
+    state.v[0xf] = state.Draw(vx, vy, GetRightNibble(r));
 }
 
 
 // Ex9E: if(key() == Vx); Skips the next instruction if the key stored in Vx is pressed.
 
-void ch8::SkipKeyEqualsInstruction::Execute() noexcept {}
-
-void ch8::SkipKeyEqualsInstruction::Disassemble() noexcept {
-    u8 vx = GetRightNibble(l);
+void ch8::SkipKeyEqualsInstruction::Execute() noexcept {
+    const u16 key = u16(1u << GetRightNibble(state.v[GetRightNibble(l)]));
 
-    PrintInstruction("SKE");
-    printf("V%X", vx);
+    state.keysRead |= key;
+    if (state.keys & key) {
+        state.pc += 2;
+    }
 }
 
 
 // ExA1; if(key() != Vx); Skips the next instruction if the key stored in Vx isn't pressed.
 
-void ch8::SkipKeyNotEqualsInstruction::Execute() noexcept {}
-
-void ch8::SkipKeyNotEqualsInstruction::Disassemble() noexcept {
-    u8 vx = GetRightNibble(l);
+void ch8::SkipKeyNotEqualsInstruction::Execute() noexcept {
+    const u16 key = u16(1u << GetRightNibble(state.v[GetRightNibble(l)]));
 
-    PrintInstruction("SKNE");
-    printf("V%X", vx);
+    state.keysRead |= key;
+    if (!(state.keys & key)) {
+        state.pc += 2;
+    }
 }
 
 
 // Fx07: Vx = get_delay(); Sets Vx to the value of the delay timer.
 
-void ch8::GetDelayInstruction::Execute() noexcept {}
-
-void ch8::GetDelayInstruction::Disassemble() noexcept {
-    u8 vx = GetRightNibble(l);
-
-    PrintInstruction("GETDLY");
-    printf("V%X", vx);
+void ch8::GetDelayInstruction::Execute() noexcept {
+    state.v[GetRightNibble(l)] = state.dt;
 }
 
 
 // Fx0A: Vx = get_key(); A key press is awaited, and then stored in Vx. (Blocking Operation. All instruction halted until next key event.)
 
-void ch8::GetKeyInstruction::Execute() noexcept {}
+void ch8::GetKeyInstruction::Execute() noexcept {
+    // Blocking is done by executing this instruction again, until a key is held down.
+    if (state.keys == 0) {
+        state.pc -= 2;
+        return;
+    }
 
-void ch8::GetKeyInstruction::Disassemble() noexcept {
-    u8 vx = GetRightNibble(l);
+    u8 key = 0;
+    while (!(state.keys & (1u << key))) {
+        ++key;
+    }
 
-    PrintInstruction("GETKEY");
-    printf("V%X", vx);
+    state.keysRead |= u16(1u << key);
+    state.v[GetRightNibble(l)] = key;
 }
 
 
 // Fx15: delay_timer(Vx); Sets the delay timer to Vx.
 
-void ch8::SetDelayInstruction::Execute() noexcept {}
-
-void ch8::SetDelayInstruction::Disassemble() noexcept {
-    u8 vx = GetRightNibble(l);
-
-    PrintInstruction("SETDLY");
-    printf("V%X", vx);
+void ch8::SetDelayInstruction::Execute() noexcept {
+    state.dt = state.v[GetRightNibble(l)];
 }
 
 
 // Fx18: sound_timer(Vx); Sets the sound timer to VX.
 
-void ch8::SetSoundInstruction::Execute() noexcept {}
-
-void ch8::SetSoundInstruction::Disassemble() noexcept {
-    u8 vx = GetRightNibble(l);
-
-    PrintInstruction("SETSND");
-    printf("V%X", vx);
+void ch8::SetSoundInstruction::Execute() noexcept {
+    state.st = state.v[GetRightNibble(l)];
 }
 
 
 // Fx1E: I += Vx; Adds Vx to i. Vf is set to 1 when there is a range overflow (I + Vx > 0xFFF), and to 0 when there isn't.
 
-void ch8::AddToAddressInstruction::Execute() noexcept {}
+void ch8::AddToAddressInstruction::Execute() noexcept {
+    u32 sum = state.i + state.v[GetRightNibble(l)];
 
-void ch8::AddToAddressInstruction::Disassemble() noexcept {
-    u8 vx = GetRightNibble(l);
-
-    PrintInstruction("ADDI");
-    printf("V%X", vx);
+    state.i = u16(sum);
+    state.v[0xf] = sum > 0xfff;
 }
 
 
 // Fx29: I = sprite_addr[Vx]; Sets I to the location of the sprite for the character in Vx.
 // Characters 0-F (in hexadecimal) are represented by a 4x5 font.
 
-void ch8::SetSpriteInstruction::Execute() noexcept {}
-
-void ch8::SetSpriteInstruction::Disassemble() noexcept {
-    u8 vx = GetRightNibble(l);
-
-    PrintInstruction("SPRITE");
-    printf("V%X", vx);
+void ch8::SetSpriteInstruction::Execute() noexcept {
+    state.i = FONT_START + GetRightNibble(state.v[GetRightNibble(l)]) * 5;
 }
 
 
@@ -419,37 +500,30 @@ the tens digit at location i+1, and the ones digit at location i+2.)
 (BCD = binary coded decimal);
 */
 
-void ch8::SetBcdInstruction::Execute() noexcept {}
+void ch8::SetBcdInstruction::Execute() noexcept {
+    u8 vx = state.v[GetRightNibble(l)];
 
-void ch8::SetBcdInstruction::Disassemble() noexcept {
-    u8 vx = GetRightNibble(l);
-
-    PrintInstruction("BCD");
-    printf("V%X", vx);
+    state.Store(state.i,     vx / 100);
+    state.Store(state.i + 1, vx / 10 % 10);
+    state.Store(state.i + 2, vx % 10);
 }
 
 
 // Fx55: reg_dump(Vx, &i); Stores V0 to Vx (including Vx) in memory starting at address i.
 // The offset from i is increased by 1 for each value written, but i itself is left unmodified.
 
-void ch8::SaveRegistersInstruction::Execute() noexcept {}
-
-void ch8::SaveRegistersInstruction::Disassemble() noexcept {
-    u8 vx = GetRightNibble(l);
-
-    PrintInstruction("SAVE");
-    printf("V%X", vx);
+void ch8::SaveRegistersInstruction::Execute() noexcept {
+    for (u8 x = 0; x <= GetRightNibble(l); ++x) {
+        state.Store(state.i + x, state.v[x]);
+    }
 }
 
 
 // Fx65: reg_load(Vx, &i); Fills V0 to Vx (including Vx) with values from memory starting at address i.
 // The offset from i is increased by 1 for each value written, but i itself is left unmodified.
 
-void ch8::LoadRegistersInstruction::Execute() noexcept {}
-
-void ch8::LoadRegistersInstruction::Disassemble() noexcept {
-    u8 vx = GetRightNibble(l);
-
-    PrintInstruction("LOAD");
-    printf("V%X", vx);
-}
\ No newline at end of file
+void ch8::LoadRegistersInstruction::Execute() noexcept {
+    for (u8 x = 0; x <= GetRightNibble(l); ++x) {
+        state.v[x] = state.At(state.i + x);
+    }
+}
@@ -2,10 +2,12 @@
 #define GOGA_TAMAS_CHIP_8_CHIP8_HPP
 
 #include <array>
+#include <cstddef>
 #include <vector>
 #include <memory>
+#include <algorithm>
 #include "defines.hpp"
-#include "sdl.hpp"
+#include "opcodes.hpp"
 
 // Contains the Chip-8's CPU layout & all of its instructions.
 
@@ -13,27 +15,125 @@
 //       I couldn't find any authoritative resource that prohibited me from doing so.
 
 namespace ch8 {
+    // A memory cell's share of the memory's hash. Zeroes don't count, so a wiped memory hashes to 0.
+    inline u64 HashCell(u16 address, u8 value) noexcept {
+        if (value == 0) {
+            return 0;
+        }
+
+        u64 x = (u64(address & (MEM_SIZE - 1)) << 8 | value) + 0x9e3779b97f4a7c15ull;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+    }
+
+    // Gets told about stores to watched pages, see Chip8::watchedPages.
+    struct Watcher {
+        virtual ~Watcher() {}
+        virtual void Stored(u16 address, u8 before, u8 after) noexcept = 0;
+    };
+
+    constexpr u16 PAGE_SHIFT = 8;   // 16 pages of 256 bytes
+
+    constexpr std::size_t CACHE_LINE = 64;
+
+    // Heap allocation that keeps a type's alignment, which new only does from C++17 on. Derive from it to use it.
+    struct CacheAligned {
+        static void* operator new(std::size_t size);
+        static void operator delete(void* pointer) noexcept;
+    };
+
     // The Chip-8's CPU.
-    struct Chip8 {
+    // Laid out for the interpreter: the registers share the first cache line & the memory starts on the next one.
+    // What stores & key tests keep up to date besides the memory shares the line after it, with the debugger's hook.
+    // See the asserts below.
+    struct alignas(CACHE_LINE) Chip8: CacheAligned {
+        // Hot: one cache line
         std::array<u8, 16>          v;      // Registers
+        std::array<u16, STACK_SIZE> stack;  // Decided to implement the stack separately, to make my life easier
         u16                         i;      // Big register, usually for storing an address
         u16                         sp;     // Stack pointer
         u16                         pc;     // Program counter
         u8                          dt;     // Delay timer
         u8                          st;     // Sound timer
-        std::array<u16, STACK_SIZE> stack;  // Decided to implement the stack separately, to make my life easier
+        u16                         keys;   // Keypad: bit n is set while key n is held down
+        u16                         watchedPages = 0;       // Bit n: stores to page n are reported to the watcher
+        u32                         seed;   // State of the random number generator
+
+        std::array<u8, MEM_SIZE>    memory; // The font lives at FONT_START, the (bit-packed) display at SCREEN_START
+
+        // Written by stores & key tests: one cache line
+        u64                         memoryHash; // XOR of every cell's HashCell, kept up to date by the writes
+        u16                         keysRead     = 0;   // Bit n: key n was tested (Ex9E, ExA1, Fx0A), see latency.hpp
+
+        // Cold
+        Watcher*                    watcher      = nullptr;
 
         Chip8() {
+            Wipe();
             Reset();
         }
 
-        void Reset() {
-            stack.fill(0);
-            sp = 0;
-            pc = MEM_START;
+        // Resets the CPU, clears the screen & reloads the font. The rest of the memory is left alone.
+        void Reset() noexcept;
+
+        // Zeroes the whole memory.
+        void Wipe() noexcept {
+            memory.fill(0);
+            memoryHash = 0;
+        }
+
+        // The address space is mirrored, so every address is valid.
+        u8 At(u16 address) const noexcept {
+            return memory[address & (MEM_SIZE - 1)];
+        }
+
+        // Writes should go through here (or be followed by Rehash), to keep the memory's hash up to date.
+        void Store(u16 address, u8 value) noexcept {
+            u8& cell = memory[address & (MEM_SIZE - 1)];
+
+            if (watchedPages & (1u << ((address & (MEM_SIZE - 1)) >> PAGE_SHIFT))) {
+                watcher->Stored(address & (MEM_SIZE - 1), cell, value);
+            }
+
+            memoryHash ^= HashCell(address, cell) ^ HashCell(address, value);
+            cell = value;
         }
+
+        void Rehash() noexcept;
+
+        // The hash of the whole machine: registers, stack, timers, RNG & memory (the screen included).
+        // Only the registers are hashed here, the memory's hash is updated as it's written.
+        u64 Hash() const noexcept;
+
+        void ClearScreen() noexcept;
+
+        // Called at 60 Hz.
+        void TickTimers() noexcept {
+            if (dt > 0) --dt;
+            if (st > 0) --st;
+        }
+
+        // Xorshift, so that runs are reproducible given the same seed.
+        u8 Random() noexcept {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            return u8(seed);
+        }
+
+        // XORs the n byte tall sprite at i onto the screen, at (x, y). Returns 1 if a pixel was switched off, 0 otherwise.
+        // The starting position wraps around the screen, but the sprite itself is clipped.
+        u8 Draw(u8 x, u8 y, u8 n) noexcept;
     };
 
+    static_assert(alignof(Chip8) == CACHE_LINE, "The machine should start on a cache line");
+    static_assert(offsetof(Chip8, seed) + sizeof(Chip8::seed) <= CACHE_LINE, "The registers should fit in a cache line");
+    static_assert(offsetof(Chip8, memory) == CACHE_LINE, "The memory should start on the second cache line");
+    static_assert(offsetof(Chip8, memoryHash) == CACHE_LINE + MEM_SIZE, "The memory's hash should start the line after the memory");
+    static_assert(offsetof(Chip8, keysRead) + sizeof(Chip8::keysRead) <= 2 * CACHE_LINE + MEM_SIZE, "What stores & key tests write should share a cache line");
+    static_assert(offsetof(Chip8, watcher) > offsetof(Chip8, keysRead), "The cold data should come last");
+
     // Bit twiddling.
     inline u8 GetRightNibble(u8 x) { return x & 0x0f; }
     inline u8 GetLeftNibble(u8 x)  { return (x & 0xf0) >> 4;}
@@ -67,18 +167,14 @@ namespace ch8 {
     // 0x0
     class ClearScreenInstruction: public Instruction {
     public:
-        ClearScreenInstruction(Chip8& s, Interface& i, u8 l, u8 r): Instruction(s,l,r), interface(i) {}
+        ClearScreenInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
-    private:
-        Interface& interface;
     };
 
     class ReturnInstruction: public Instruction {
     public:
         ReturnInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     // 0x1
@@ -86,7 +182,6 @@ namespace ch8 {
     public:
         JumpInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     // 0x2
@@ -94,7 +189,6 @@ namespace ch8 {
     public:
         CallInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     // 0x3
@@ -102,7 +196,6 @@ namespace ch8 {
     public:
         SkipEqualInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     // 0x4
@@ -110,7 +203,6 @@ namespace ch8 {
     public:
         SkipNotEqualInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     // 0x5
@@ -118,7 +210,6 @@ namespace ch8 {
     public:
         SkipRegisterEqualInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     // 0x6
@@ -126,7 +217,6 @@ namespace ch8 {
     public:
         MoveInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     // 0x7
@@ -134,7 +224,6 @@ namespace ch8 {
     public:
         AddInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     // 0x8
@@ -142,63 +231,54 @@ namespace ch8 {
     public:
         MoveRegisterInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     class OrInstruction: public Instruction {
     public:
         OrInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     class AndInstruction: public Instruction {
     public:
         AndInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     class XorInstruction: public Instruction {
     public:
         XorInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     class AddRegisterInstruction: public Instruction {
     public:
         AddRegisterInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     class SubInstruction: public Instruction {
     public:
         SubInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     class ShiftRightInstruction: public Instruction {
     public:
         ShiftRightInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     class SubInverseInstruction: public Instruction {
     public:
         SubInverseInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     class ShiftLeftInstruction: public Instruction {
     public:
         ShiftLeftInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     // 0x9
@@ -206,7 +286,6 @@ namespace ch8 {
     public:
         SkipRegisterNotEqualInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     // 0xA
@@ -214,7 +293,6 @@ namespace ch8 {
     public:
         MoveAddressInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     // 0xB
@@ -222,7 +300,6 @@ namespace ch8 {
     public:
         JumpRegisterInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     // 0xC
@@ -230,7 +307,6 @@ namespace ch8 {
     public:
         RandomMaskInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     // 0xD
@@ -238,7 +314,6 @@ namespace ch8 {
     public:
         DrawInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     // 0xE
@@ -246,14 +321,12 @@ namespace ch8 {
     public:
         SkipKeyEqualsInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     class SkipKeyNotEqualsInstruction: public Instruction {
     public:
         SkipKeyNotEqualsInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     // 0xF -- F stands for Fun!
@@ -261,63 +334,54 @@ namespace ch8 {
     public:
         GetDelayInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     class GetKeyInstruction: public Instruction {
     public:
         GetKeyInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     class SetDelayInstruction: public Instruction {
     public:
         SetDelayInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     class SetSoundInstruction: public Instruction {
     public:
         SetSoundInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     class AddToAddressInstruction: public Instruction {
     public:
         AddToAddressInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     class SetSpriteInstruction: public Instruction {
     public:
         SetSpriteInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     class SetBcdInstruction: public Instruction {
     public:
         SetBcdInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     class SaveRegistersInstruction: public Instruction {
     public:
         SaveRegistersInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 
     class LoadRegistersInstruction: public Instruction {
     public:
         LoadRegistersInstruction(Chip8& s, u8 l, u8 r): Instruction(s,l,r) {}
         void Execute() noexcept override;
-        void Disassemble() noexcept override;
     };
 }
 
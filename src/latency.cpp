@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <string>
+#include "latency.hpp"
+
+// Histogram
+
+void ch8::Histogram::Add(std::chrono::microseconds latency) noexcept {
+    // The input is only known to the millisecond, so it may seem to come a little after what it caused.
+    latency = std::max(latency, std::chrono::microseconds(0));
+
+    ++bins[std::min<u64>(u64(latency.count()) / BIN_US, BINS)];
+    ++count;
+    max = std::max(max, latency);
+}
+
+double ch8::Histogram::Percentile(double fraction) const noexcept {
+    const u64 wanted = u64(fraction * count + 0.5);
+    u64 seen = 0;
+
+    for (u32 bin = 0; bin < BINS; ++bin) {
+        seen += bins[bin];
+
+        if (seen >= wanted && seen > 0) {
+            return (bin + 1) * BIN_US / 1000.0;
+        }
+    }
+
+    return max.count() / 1000.0;
+}
+
+void ch8::Histogram::Print(FILE* out, const char* name) const {
+    fprintf(out, "%-20s %6llu presses   p50 %6.2f ms   p90 %6.2f ms   p99 %6.2f ms   max %6.2f ms\n", name,
+            (unsigned long long)count, Percentile(0.5), Percentile(0.9), Percentile(0.99), max.count() / 1000.0);
+
+    if (count == 0) {
+        return;
+    }
+
+    constexpr u32 PER_MS = 1000 / BIN_US;
+    constexpr u32 WIDTH  = 50;
+
+    for (u32 low = 0, high = 1; low * PER_MS <= BINS; low = high, high *= 2) {
+        const u32 first = low * PER_MS;
+        const u32 last  = std::min(high * PER_MS, BINS + 1);
+        u64 sum = 0;
+
+        for (u32 bin = first; bin < last; ++bin) {
+            sum += bins[bin];
+        }
+
+        if (sum == 0) {
+            continue;
+        }
+
+        const std::string bar(std::max<u64>(1, sum * WIDTH / count), '#');
+
+        if (last == BINS + 1) {
+            fprintf(out, "    %4u+     ms %6llu %s\n", low, (unsigned long long)sum, bar.c_str());
+        } else {
+            fprintf(out, "    %4u-%-4u ms %6llu %s\n", low, high, (unsigned long long)sum, bar.c_str());
+        }
+    }
+}
+
+
+// Latency
+
+void ch8::Latency::Pressed(u32 key, clock::time_point when) noexcept {
+    Press& press = keys[key];
+
+    if (press.stage == STAGE_NONE) {
+        press.stage = STAGE_PRESSED;
+        press.input = when;
+        ++pressed;
+    }
+}
+
+void ch8::Latency::Released(u32 key) noexcept {
+    Press& press = keys[key];
+
+    if (press.stage == STAGE_PRESSED) {
+        press.stage = STAGE_NONE;
+        ++missed;
+    }
+}
+
+void ch8::Latency::Started(Chip8& state) noexcept {
+    state.keysRead = 0;
+    started = clock::now();
+}
+
+void ch8::Latency::Finished(const Chip8& state) noexcept {
+    using std::chrono::duration_cast;
+    using std::chrono::microseconds;
+
+    const auto now = clock::now();
+
+    for (u32 key = 0; key < keys.size(); ++key) {
+        Press& press = keys[key];
+
+        if (press.stage == STAGE_PRESSED && (state.keysRead & (1u << key))) {
+            press.stage = STAGE_FINISHED;
+            press.read = started;
+            press.finished = now;
+
+            toRead.Add(duration_cast<microseconds>(press.read - press.input));
+            toFinished.Add(duration_cast<microseconds>(press.finished - press.input));
+        }
+    }
+}
+
+void ch8::Latency::Presented() noexcept {
+    const auto now = clock::now();
+
+    for (Press& press: keys) {
+        if (press.stage == STAGE_FINISHED) {
+            press.stage = STAGE_NONE;
+            toPresented.Add(std::chrono::duration_cast<std::chrono::microseconds>(now - press.input));
+        }
+    }
+}
+
+void ch8::Latency::Report(FILE* out) const {
+    fprintf(out, "Input latency: %llu key presses, %llu missed (released before the machine read them)\n",
+            (unsigned long long)pressed, (unsigned long long)missed);
+
+    toRead.Print(out, "input -> read");
+    toFinished.Print(out, "input -> finished");
+    toPresented.Print(out, "input -> presented");
+}
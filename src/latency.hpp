@@ -0,0 +1,80 @@
+#ifndef GOGA_TAMAS_CHIP_8_LATENCY_HPP
+#define GOGA_TAMAS_CHIP_8_LATENCY_HPP
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include "instructions.hpp"
+
+// Input-to-photon latency of the window, measured inside the emulator (the latency option).
+// Every key press is followed through four points in time:
+// input:     when SDL got the key event (its timestamp, which only has milliseconds),
+// read:      when the frame in which the machine first tested the key (Ex9E, ExA1 or Fx0A, see Chip8::keysRead) started,
+// finished:  when that frame was done executing,
+// presented: when it was presented, i.e. SDL_RenderPresent returned. There's no vsync, so that's when the compositor got it.
+// Frames execute in microseconds, so read & finished are close, unless fast-forwarding: they bracket the batch.
+// Presses the machine didn't look at before the key was released are counted as missed.
+// Repeats are ignored, a press is only measured once.
+// The histograms are printed to stderr once the window is closed, like the startup trace.
+
+namespace ch8 {
+    // Latencies in 250 us bins, up to BINS of them (128 ms). Longer ones go to the last bin.
+    class Histogram {
+    public:
+        static constexpr u32 BIN_US = 250;
+        static constexpr u32 BINS   = 512;
+
+        void Add(std::chrono::microseconds latency) noexcept;
+
+        u64 Count() const noexcept {
+            return count;
+        }
+
+        // In milliseconds: the upper end of the bin that the given fraction of the samples fall in or below.
+        double Percentile(double fraction) const noexcept;
+
+        // A line of percentiles, then a bar per power of 2 milliseconds.
+        void Print(FILE* out, const char* name) const;
+
+    private:
+        std::array<u64, BINS + 1> bins = {};
+        u64 count = 0;
+        std::chrono::microseconds max{0};
+    };
+
+    class Latency {
+    public:
+        using clock = std::chrono::steady_clock;
+
+        void Pressed(u32 key, clock::time_point when) noexcept;
+        void Released(u32 key) noexcept;
+
+        // Around executing frames: Started clears keysRead, Finished looks at what was read since.
+        void Started(Chip8& state) noexcept;
+        void Finished(const Chip8& state) noexcept;
+        void Presented() noexcept;
+
+        void Report(FILE* out) const;
+
+    private:
+        enum STAGE: u8 {
+            STAGE_NONE,
+            STAGE_PRESSED,      // Waiting for the machine to read it
+            STAGE_FINISHED      // Waiting for the frame to be presented
+        };
+
+        struct Press {
+            STAGE             stage = STAGE_NONE;
+            clock::time_point input, read, finished;
+        };
+
+        std::array<Press, 16> keys;
+        clock::time_point started;
+
+        Histogram toRead, toFinished, toPresented;
+        u64 pressed = 0;
+        u64 missed  = 0;
+    };
+}
+
+#endif // GOGA_TAMAS_CHIP_8_LATENCY_HPP
@@ -0,0 +1,79 @@
+#include <cstring>
+#include <new>
+#include "chip8.hpp"
+#include "libchip8.h"
+
+static_assert(CHIP8_MAX_ROM == ch8::MAX_PROG_LEN, "The header's ROM size is out of date");
+static_assert(CHIP8_SCREEN_BYTES == ch8::MEM_SIZE - ch8::SCREEN_START, "The header's screen size is out of date");
+
+// Behind the opaque handle: the machine, its program & the seed chip8_load starts the machine from (0: the default).
+struct chip8_machine: ch8::CacheAligned {
+    ch8::Chip8   state;
+    ch8::Program program;
+    u32          seed;
+
+    explicit chip8_machine(u32 seed)
+        : program(state, nullptr, 0)
+        , seed(seed)
+    {}
+};
+
+uint32_t chip8_abi_version(void) {
+    return CHIP8_ABI_VERSION;
+}
+
+chip8_machine* chip8_create(uint32_t seed) {
+    try {
+        return new chip8_machine(seed);
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void chip8_destroy(chip8_machine* machine) {
+    delete machine;
+}
+
+int chip8_load(chip8_machine* machine, const uint8_t* rom, size_t length) {
+    if (length > CHIP8_MAX_ROM) {
+        return CHIP8_TOO_LARGE;
+    }
+
+    try {
+        machine->program.Assign(rom, length);
+    } catch (const std::bad_alloc&) {
+        return CHIP8_NO_MEMORY;
+    }
+
+    machine->program.Load();
+
+    if (machine->seed != 0) {
+        machine->state.seed = machine->seed;
+    }
+
+    return CHIP8_OK;
+}
+
+void chip8_step(chip8_machine* const* machines, const uint16_t* keys, size_t count, uint32_t frames) {
+    for (size_t n = 0; n < count; ++n) {
+        if (keys != nullptr) {
+            machines[n]->state.keys = keys[n];
+        }
+
+        machines[n]->program.RunFrames(frames);
+    }
+}
+
+void chip8_read_screens(const chip8_machine* const* machines, size_t count, uint8_t* screens) {
+    for (size_t n = 0; n < count; ++n) {
+        memcpy(screens + n * CHIP8_SCREEN_BYTES, &machines[n]->state.memory[ch8::SCREEN_START], CHIP8_SCREEN_BYTES);
+    }
+}
+
+uint64_t chip8_hash(const chip8_machine* machine) {
+    return machine->state.Hash();
+}
+
+int chip8_beeping(const chip8_machine* machine) {
+    return machine->state.st > 0;
+}
@@ -0,0 +1,68 @@
+#ifndef GOGA_TAMAS_CHIP_8_LIBCHIP8_H
+#define GOGA_TAMAS_CHIP_8_LIBCHIP8_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* The emulation core as a library, with a C ABI: build it with `make lib` (libchip8.a & libchip8.so, no SDL needed).
+ * Machines are opaque, and driven in batches: one call steps any number of them, with a key mask each,
+ * and another copies their screens out, back to back, into one buffer of the caller's.
+ * Nothing here throws, keeps global state or prints; machines may be used from any thread, one thread at a time.
+ * See tools/libchip8-example.c.
+ *
+ * ABI: functions are only ever added. Anything else bumps CHIP8_ABI_VERSION. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CHIP8_ABI_VERSION  1
+
+#define CHIP8_MAX_ROM      3328        /* Bytes, from 0x200 up to the screen */
+#define CHIP8_SCREEN_BYTES 256         /* 64x32, bit-packed: 8 bytes a row, the leftmost pixel in the top bit */
+
+#if defined(__GNUC__)
+#define CHIP8_API __attribute__((visibility("default")))
+#else
+#define CHIP8_API
+#endif
+
+typedef struct chip8_machine chip8_machine;
+
+enum chip8_status {
+    CHIP8_OK = 0,
+    CHIP8_TOO_LARGE,    /* The ROM doesn't fit in memory */
+    CHIP8_NO_MEMORY
+};
+
+/* CHIP8_ABI_VERSION of the library, to check against the header's. */
+CHIP8_API uint32_t chip8_abi_version(void);
+
+/* A machine with no ROM. The seed is the random number generator's, it's reapplied on every load;
+ * 0 keeps the interpreter's own, so runs match golden traces. NULL if it couldn't be allocated. */
+CHIP8_API chip8_machine* chip8_create(uint32_t seed);
+
+/* NULL is ignored. */
+CHIP8_API void chip8_destroy(chip8_machine* machine);
+
+/* Replaces the ROM & resets the machine. The bytes are copied. Odd ROMs are padded with a zero, like files are. */
+CHIP8_API int chip8_load(chip8_machine* machine, const uint8_t* rom, size_t length);
+
+/* Runs count machines for the given number of frames each (10 instructions, then a tick of the timers).
+ * keys[n] is held down on machine n throughout: bit k is key k. With keys NULL, the keys are left as they were. */
+CHIP8_API void chip8_step(chip8_machine* const* machines, const uint16_t* keys, size_t count, uint32_t frames);
+
+/* Copies the screens of count machines into screens, CHIP8_SCREEN_BYTES each, in order. */
+CHIP8_API void chip8_read_screens(const chip8_machine* const* machines, size_t count, uint8_t* screens);
+
+/* The hash of the whole machine: registers, stack, timers, random number generator & memory. */
+CHIP8_API uint64_t chip8_hash(const chip8_machine* machine);
+
+/* Whether the sound timer is running, i.e. the machine beeps. */
+CHIP8_API int chip8_beeping(const chip8_machine* machine);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* GOGA_TAMAS_CHIP_8_LIBCHIP8_H */
@@ -1,11 +1,31 @@
 #include <iostream>
 #include <exception>
 #include "chip8.hpp"
+#include "sdl.hpp"
+#include "debugger.hpp"
+#include "server.hpp"
+#include "terminal.hpp"
+#include "tiles.hpp"
 
 // OPTIONS:
 // hex
 // asm
 // noexec
+// aot (writes the ROM as C++ to stdout, see aot.hpp)
+// phosphor (fades pixels out, instead of flickering)
+// turbo, turbo=N (starts fast-forwarding, uncapped or at N times the speed; Tab toggles it)
+// record=FILE, verify=FILE (headless run, writing or checking a golden trace, see golden.hpp)
+// frames=N (length of recorded golden traces, 36000 by default)
+// trace=FILE, compress (records an execution trace, optionally compressed, see trace.hpp & tools/trace.cpp)
+// debug (headless debugger, reading commands from stdin, see debugger.hpp)
+// y4m=FILE, pbm=PREFIX, ppm=PREFIX, changed (headless frame export, "-" is stdout for y4m, see export.hpp)
+// serve (the path is a UNIX socket to serve headless instances on, instead of a ROM, see server.hpp)
+// publish=NAME (publishes the machine in shared memory after every frame, see shared.hpp)
+// tiles=N (runs N machines side by side in one window, see tiles.hpp)
+// optimize=FILE (writes the ROM with fewer instructions to execute, & reports how many fewer headless, see optimizer.hpp)
+// term, term=braille (draws in the terminal instead of a window, for displayless machines, see terminal.hpp)
+// latency (measures how long key presses take to be read, executed & presented in the window, see latency.hpp)
+// startup-trace (prints the time it took to get to each step of starting up, up to the first frames, to stderr)
 
 void Run(int argc, char** argv) {
     using std::cout;
@@ -20,8 +40,30 @@ void Run(int argc, char** argv) {
         return;
     }
 
-    if (os::HasFileError()) {
-        cout << os::GetFileError() << endl;
+    if (program.arguments.IsEnabled(ch8::OPTIONS_SERVE)) {
+        ch8::server::Server server(program.arguments.path);
+        server.Run();
+        return;
+    }
+
+    if (!program.loaded.Ok()) {
+        cout << program.loaded.Message() << endl;
+        return;
+    }
+
+    // The translation unit goes to stdout, so nothing else may be printed.
+    if (program.arguments.IsEnabled(ch8::OPTIONS_AOT)) {
+        program.Recompile(stdout);
+        return;
+    }
+
+    // Same for exported frames, which may be going to stdout as well.
+    if (program.arguments.IsEnabled(ch8::OPTIONS_EXPORT)) {
+        ch8::Exporter exporter(ch8::EXPORT_FORMAT(program.arguments.format), program.arguments.output,
+                               program.arguments.IsEnabled(ch8::OPTIONS_CHANGED));
+
+        program.Export(exporter, program.arguments.frames);
+        fprintf(stderr, "%u frames exported\n", exporter.Written());
         return;
     }
 
@@ -37,10 +79,26 @@ void Run(int argc, char** argv) {
         cout << endl;
     }
 
-    if (!program.arguments.IsEnabled(ch8::OPTIONS_NOEXEC)) {
+    if (program.arguments.IsEnabled(ch8::OPTIONS_DEBUG)) {
+        ch8::Debugger debugger(program, state);
+        debugger.Run(std::cin);
+    } else if (program.arguments.IsEnabled(ch8::OPTIONS_RECORD)) {
+        program.Record(program.arguments.golden, program.arguments.frames);
+    } else if (program.arguments.IsEnabled(ch8::OPTIONS_VERIFY)) {
+        program.Verify(program.arguments.golden);
+    } else if (program.arguments.IsEnabled(ch8::OPTIONS_OPTIMIZE)) {
+        program.Optimize(program.arguments.optimized, program.arguments.frames);
+    } else if (program.arguments.IsEnabled(ch8::OPTIONS_TERMINAL)) {
+        ch8::terminal::Terminal terminal(program, state, ch8::terminal::GLYPHS(program.arguments.glyphs));
+        terminal.Execute();
+    } else if (program.arguments.IsEnabled(ch8::OPTIONS_TILES)) {
+        ch8::Tiles tiles(interface, program.arguments, program.arguments.tiles);
+        tiles.Execute();
+    } else if (!program.arguments.IsEnabled(ch8::OPTIONS_NOEXEC)) {
         program.Execute();
     }
 
+    os::MarkLast("Done");
     cout << program.arguments.options << ' ' << program.arguments.path << endl;
 }
 
@@ -52,7 +110,7 @@ int QuickTest(int argc, char** argv) {
     ch8::Interface interface;
     ch8::Program program(state, interface, "roms/games/Paddles.ch8", 1);
     // emu::Program program("roms/programs/SQRT Test [Sergey Naydenov, 2010].ch8", 1);
-    cout << os::GetFileError() << endl;
+    cout << program.loaded.Message() << endl;
 
     // program.DumpHex();
     program.Disassemble();
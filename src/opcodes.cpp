@@ -0,0 +1,77 @@
+#include "opcodes.hpp"
+
+// The table is filled in pattern by pattern: each pattern only visits the opcodes it matches,
+// by counting down through the subsets of its operand bits. That's 40K steps in all, which compilers allow.
+// Patterns that overlap, aren't 4 characters or are out of order don't compile.
+
+static constexpr u16 nibble(char c) {
+    return c >= '0' && c <= '9' ? c - '0'
+         : c >= 'a' && c <= 'f' ? c - 'a' + 10
+         : 0x10;
+}
+
+static constexpr u16 fixedBits(const char* pattern) {
+    u16 mask = 0;
+
+    for (u32 k = 0; k < 4; ++k) {
+        if (pattern[k] == '\0') {
+            throw "Patterns have to be 4 characters long";
+        }
+
+        mask = mask << 4 | (nibble(pattern[k]) < 0x10 ? 0xf : 0x0);
+    }
+
+    return mask;
+}
+
+static constexpr u16 fixedValue(const char* pattern) {
+    u16 value = 0;
+
+    for (u32 k = 0; k < 4; ++k) {
+        value = value << 4 | (nibble(pattern[k]) & 0xf);
+    }
+
+    return value;
+}
+
+static constexpr ch8::OpcodeTable generate() {
+    ch8::OpcodeTable table = {};
+
+    for (u32 p = 0; p < ch8::OP_COUNT; ++p) {
+        const ch8::Pattern& pattern = ch8::PATTERNS[p];
+
+        if (pattern.opcode != p) {
+            throw "PATTERNS have to be in the order of OPCODE";
+        }
+
+        if (pattern.pattern[0] == '\0') {
+            continue;
+        }
+
+        const u16 value = fixedValue(pattern.pattern);
+        const u16 operands = u16(~fixedBits(pattern.pattern));
+
+        for (u32 bits = operands; ; bits = (bits - 1) & operands) {
+            if (table.opcodes[value | bits] != ch8::OP_NOP) {
+                throw "Patterns can't overlap";
+            }
+
+            table.opcodes[value | bits] = pattern.opcode;
+
+            if (bits == 0) {
+                break;
+            }
+        }
+    }
+
+    return table;
+}
+
+constexpr ch8::OpcodeTable ch8::OPCODE_TABLE = generate();
+
+static_assert(ch8::OPCODE_TABLE.opcodes[0x00e0] == ch8::OP_CLS, "");
+static_assert(ch8::OPCODE_TABLE.opcodes[0x05e0] == ch8::OP_CLS, "");
+static_assert(ch8::OPCODE_TABLE.opcodes[0x0123] == ch8::OP_NOP, "");
+static_assert(ch8::OPCODE_TABLE.opcodes[0x8abe] == ch8::OP_SHL, "");
+static_assert(ch8::OPCODE_TABLE.opcodes[0x8ab8] == ch8::OP_NOP, "");
+static_assert(ch8::OPCODE_TABLE.opcodes[0xf165] == ch8::OP_LD_V_I, "");
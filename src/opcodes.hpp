@@ -0,0 +1,119 @@
+#ifndef GOGA_TAMAS_CHIP_8_OPCODES_HPP
+#define GOGA_TAMAS_CHIP_8_OPCODES_HPP
+
+#include "defines.hpp"
+
+// The instruction set, as a list of patterns. The table that maps each of the 65536 possible opcodes to its OPCODE
+// is generated from it (at compile time), and so is the disassembly. Nothing else looks at the nibbles:
+// the interpreter (Program::Build), the recompiler (aot.cpp), the trace recorder & the analyses switch on Classify.
+// Adding an instruction means adding its OPCODE & its pattern, then handling it in each of those switches.
+
+namespace ch8 {
+    // Every instruction there is, named after its mnemonic. In the same order as PATTERNS.
+    enum OPCODE: u8 {
+        OP_NOP = 0,     // 0nnn & the undefined ones, which are ignored
+        OP_CLS,
+        OP_RET,
+        OP_JP,
+        OP_CALL,
+        OP_SE,
+        OP_SNE,
+        OP_SE_V,
+        OP_LD,
+        OP_ADD,
+        OP_LD_V,
+        OP_OR,
+        OP_AND,
+        OP_XOR,
+        OP_ADD_V,
+        OP_SUB,
+        OP_SHR,
+        OP_SUBN,
+        OP_SHL,
+        OP_SNE_V,
+        OP_LD_I,
+        OP_JP_V0,
+        OP_RND,
+        OP_DRW,
+        OP_SKP,
+        OP_SKNP,
+        OP_LD_V_DT,
+        OP_LD_K,
+        OP_LD_DT,
+        OP_LD_ST,
+        OP_ADD_I,
+        OP_LD_F,
+        OP_LD_B,
+        OP_LD_I_V,
+        OP_LD_V_I,
+        OP_COUNT
+    };
+
+    // Patterns are 4 characters, one per nibble: hex digits have to match, anything else is an operand.
+    // '_' marks a nibble that isn't used, but isn't checked either (the original interpreters ignore it).
+    // The operands of the disassembly are printed with these placeholders:
+    // {x}, {y}:  the register nibbles, in hex
+    // {nnn}:     the address, in hex
+    // {nn}:      the low byte, signed
+    // {kk}:      the low byte, unsigned
+    // {n}:       the low nibble, 2 digits
+    struct Pattern {
+        const char* pattern;
+        OPCODE      opcode;
+        const char* mnemonic;
+        const char* operands;
+    };
+
+    constexpr Pattern PATTERNS[] = {
+        {"",     OP_NOP,     "; ignored", ""},     // Whatever no other pattern matches
+        {"0_e0", OP_CLS,     "CLS",       ""},
+        {"0_ee", OP_RET,     "RET",       ""},
+        {"1nnn", OP_JP,      "JMP",       "{nnn}"},
+        {"2nnn", OP_CALL,    "CALL",      "{nnn}"},
+        {"3xnn", OP_SE,      "SE",        "V{x}, {nn}"},
+        {"4xnn", OP_SNE,     "SNE",       "V{x}, {nn}"},
+        {"5xy_", OP_SE_V,    "SRE",       "V{x}, V{y}"},
+        {"6xnn", OP_LD,      "MOV",       "V{x}, {nn}"},
+        {"7xnn", OP_ADD,     "ADD",       "V{x}, {nn}"},
+        {"8xy0", OP_LD_V,    "MOVR",      "V{x}, V{y}"},
+        {"8xy1", OP_OR,      "OR",        "V{x}, V{y}"},
+        {"8xy2", OP_AND,     "AND",       "V{x}, V{y}"},
+        {"8xy3", OP_XOR,     "XOR",       "V{x}, V{y}"},
+        {"8xy4", OP_ADD_V,   "ADDR",      "V{x}, V{y}"},
+        {"8xy5", OP_SUB,     "SUB",       "V{x}, V{y}"},
+        {"8xy6", OP_SHR,     "SHR",       "V{x}"},
+        {"8xy7", OP_SUBN,    "SUBINV",    "V{x}, V{y}"},
+        {"8xye", OP_SHL,     "SHL",       "V{x}"},
+        {"9xy_", OP_SNE_V,   "SRNE",      "V{x}, V{y}"},
+        {"annn", OP_LD_I,    "MOVI",      "{nnn}"},
+        {"bnnn", OP_JP_V0,   "JMPV",      "{nnn}"},
+        {"cxnn", OP_RND,     "RNDMSK",    "V{x}, V{kk}"},
+        {"dxyn", OP_DRW,     "DRAW",      "V{x}, V{y}, {n}"},
+        {"ex9e", OP_SKP,     "SKE",       "V{x}"},
+        {"exa1", OP_SKNP,    "SKNE",      "V{x}"},
+        {"fx07", OP_LD_V_DT, "GETDLY",    "V{x}"},
+        {"fx0a", OP_LD_K,    "GETKEY",    "V{x}"},
+        {"fx15", OP_LD_DT,   "SETDLY",    "V{x}"},
+        {"fx18", OP_LD_ST,   "SETSND",    "V{x}"},
+        {"fx1e", OP_ADD_I,   "ADDI",      "V{x}"},
+        {"fx29", OP_LD_F,    "SPRITE",    "V{x}"},
+        {"fx33", OP_LD_B,    "BCD",       "V{x}"},
+        {"fx55", OP_LD_I_V,  "SAVE",      "V{x}"},
+        {"fx65", OP_LD_V_I,  "LOAD",      "V{x}"},
+    };
+
+    static_assert(sizeof(PATTERNS) / sizeof(PATTERNS[0]) == OP_COUNT, "Every OPCODE needs a pattern");
+
+    struct OpcodeTable {
+        u8 opcodes[0x10000];
+    };
+
+    // Generated from PATTERNS, see opcodes.cpp.
+    extern const OpcodeTable OPCODE_TABLE;
+
+    inline OPCODE Classify(u8 l, u8 r) noexcept {
+        return OPCODE(OPCODE_TABLE.opcodes[l << 8 | r]);
+    }
+}
+
+#endif // GOGA_TAMAS_CHIP_8_OPCODES_HPP
@@ -0,0 +1,406 @@
+#include <algorithm>
+#include <array>
+#include "optimizer.hpp"
+
+using namespace ch8;
+using optimizer::Result;
+
+namespace {
+    enum FLAGS: u8 {
+        FLAG_CODE   = 0x1,  // Reachable
+        FLAG_LEADER = 0x2,  // Control flow lands here, other than by falling through
+        FLAG_FIXED  = 0x4   // Never rewritten nor moved
+    };
+
+    constexpr u32 MAX_HOPS   = 16;      // Of a jump chain, so that loops of jumps end
+    constexpr u16 V_ALL      = 0xffff;
+    constexpr u16 VF         = 0x8000;
+
+    struct Analysis {
+        const std::vector<u8>& rom;
+        u32                    words;
+        std::vector<u8>        flags;
+        std::vector<u16>       windows;             // Bnnn: nnn
+        bool                   misaligned = false;  // Control flow lands on an odd address of the ROM
+    };
+}
+
+static OPCODE opcodeOf(const std::vector<u8>& bytes, u32 word) noexcept {
+    return Classify(bytes[word * 2], bytes[word * 2 + 1]);
+}
+
+static u16 targetOf(const std::vector<u8>& bytes, u32 word) noexcept {
+    return u16((bytes[word * 2] & 0x0f) << 8 | bytes[word * 2 + 1]);
+}
+
+static bool isSkip(OPCODE opcode) noexcept {
+    return opcode == OP_SE || opcode == OP_SNE || opcode == OP_SE_V || opcode == OP_SNE_V
+        || opcode == OP_SKP || opcode == OP_SKNP;
+}
+
+static bool isTerminator(OPCODE opcode) noexcept {
+    return opcode == OP_JP || opcode == OP_RET || opcode == OP_JP_V0;
+}
+
+// The registers an instruction reads & writes, as masks: bit n is Vn. A call might do anything.
+static u16 reads(OPCODE opcode, u8 x, u8 y) noexcept {
+    switch (opcode) {
+    case OP_CALL:
+        return V_ALL;
+    case OP_SE: case OP_SNE: case OP_ADD: case OP_SHR: case OP_SHL: case OP_SKP: case OP_SKNP:
+    case OP_LD_DT: case OP_LD_ST: case OP_ADD_I: case OP_LD_F: case OP_LD_B:
+        return u16(1u << x);
+    case OP_SE_V: case OP_SNE_V: case OP_OR: case OP_AND: case OP_XOR: case OP_ADD_V: case OP_SUB: case OP_SUBN:
+    case OP_DRW:
+        return u16(1u << x | 1u << y);
+    case OP_LD_V:
+        return u16(1u << y);
+    case OP_JP_V0:
+        return 0x1;
+    case OP_LD_I_V:
+        return u16((2u << x) - 1);
+
+    default:
+        return 0;
+    }
+}
+
+static u16 writes(OPCODE opcode, u8 x) noexcept {
+    switch (opcode) {
+    case OP_CALL:
+        return V_ALL;
+    case OP_LD: case OP_ADD: case OP_LD_V: case OP_OR: case OP_AND: case OP_XOR: case OP_RND:
+    case OP_LD_V_DT: case OP_LD_K:
+        return u16(1u << x);
+    case OP_ADD_V: case OP_SUB: case OP_SHR: case OP_SUBN: case OP_SHL:
+        return u16(1u << x | VF);
+    case OP_DRW: case OP_ADD_I:
+        return VF;
+    case OP_LD_V_I:
+        return u16((2u << x) - 1);
+
+    default:
+        return 0;
+    }
+}
+
+
+// Control flow
+
+// Like flow::Analysis, marking every word reached with the given flags. Bnnn is collected, not followed.
+static void walk(Analysis& analysis, u32 root, u8 mark) {
+    std::vector<u32> work = {root};
+
+    auto land = [&](u16 address) {
+        if (address < MEM_START || u32(address - MEM_START) / 2 >= analysis.words) {
+            return;
+        }
+
+        if (address % 2 != 0) {
+            analysis.misaligned = true;
+            return;
+        }
+
+        const u32 word = (address - MEM_START) / 2;
+        analysis.flags[word] |= FLAG_LEADER;
+        work.push_back(word);
+    };
+
+    analysis.flags[root] |= FLAG_LEADER;
+
+    while (!work.empty()) {
+        u32 word = work.back();
+        work.pop_back();
+
+        for (; word < analysis.words && (analysis.flags[word] & mark) != mark; ++word) {
+            const OPCODE opcode = opcodeOf(analysis.rom, word);
+            const u16 address = MEM_START + word * 2;
+
+            analysis.flags[word] |= mark;
+
+            if (opcode == OP_CALL) {
+                land(targetOf(analysis.rom, word));
+            } else if (isSkip(opcode)) {
+                land(address + 4);
+            } else if (opcode == OP_JP) {
+                land(targetOf(analysis.rom, word));
+                break;
+            } else if (opcode == OP_JP_V0) {
+                analysis.windows.push_back(targetOf(analysis.rom, word));
+                break;
+            } else if (opcode == OP_RET) {
+                break;
+            }
+        }
+    }
+}
+
+// Entry points that can't be followed make what they reach fixed. So does the data, see optimizer.hpp.
+static void analyse(Analysis& analysis) {
+    if (analysis.words == 0) {
+        return;
+    }
+
+    walk(analysis, 0, FLAG_CODE);
+
+    // Every aligned word V0 may land on, including the ones found along the way.
+    for (std::size_t n = 0; n < analysis.windows.size(); ++n) {
+        const u32 window = analysis.windows[n];
+
+        for (u32 address = window & ~1u; address <= window + 0x100; address += 2) {
+            const u32 word = (address - MEM_START) / 2;
+
+            if (address >= MEM_START && word < analysis.words) {
+                analysis.flags[word] |= FLAG_FIXED;
+                walk(analysis, word, FLAG_CODE | FLAG_FIXED);
+            }
+        }
+    }
+
+    u32 data = MEM_SIZE;
+
+    for (u32 word = 0; word < analysis.words; ++word) {
+        const u16 target = targetOf(analysis.rom, word);
+
+        if ((analysis.flags[word] & FLAG_CODE) && opcodeOf(analysis.rom, word) == OP_LD_I && target >= MEM_START) {
+            data = std::min<u32>(data, target);
+        }
+    }
+
+    for (u32 word = 0; word < analysis.words; ++word) {
+        if (MEM_START + word * 2u + 1 >= data) {
+            analysis.flags[word] |= FLAG_FIXED;
+        }
+    }
+}
+
+
+// Rewrites
+
+static void thread(const Analysis& analysis, Result& result) {
+    for (u32 word = 0; word < analysis.words; ++word) {
+        const OPCODE opcode = opcodeOf(analysis.rom, word);
+
+        if ((analysis.flags[word] & (FLAG_CODE | FLAG_FIXED)) != FLAG_CODE || (opcode != OP_JP && opcode != OP_CALL)) {
+            continue;
+        }
+
+        u16 target = targetOf(analysis.rom, word);
+        u32 hops = 0;
+        bool returns = false;
+
+        for (;;) {
+            const u32 next = (target - MEM_START) / 2u;
+
+            if (target < MEM_START || target % 2 != 0 || next >= analysis.words || (analysis.flags[next] & FLAG_FIXED)) {
+                break;
+            }
+
+            if (opcodeOf(analysis.rom, next) == OP_RET) {
+                returns = opcode == OP_JP;
+                break;
+            }
+
+            if (opcodeOf(analysis.rom, next) != OP_JP || targetOf(analysis.rom, next) == target || hops == MAX_HOPS) {
+                break;
+            }
+
+            target = targetOf(analysis.rom, next);
+            ++hops;
+        }
+
+        if (returns) {
+            result.rom[word * 2] = 0x00;
+            result.rom[word * 2 + 1] = 0xee;
+            ++hops;
+        } else if (hops > 0) {
+            result.rom[word * 2] = u8((result.rom[word * 2] & 0xf0) | target >> 8);
+            result.rom[word * 2 + 1] = u8(target);
+        }
+
+        if (hops > 0) {
+            result.saved[word] = u8(hops);
+            ++result.threaded;
+        }
+    }
+}
+
+// Whether VF gets overwritten before it's read, from the word on. It's live at the end of the block.
+static bool vfDead(const std::vector<u8>& rom, u32 word, u32 end) noexcept {
+    for (; word < end; ++word) {
+        const OPCODE opcode = opcodeOf(rom, word);
+        const u8 x = GetRightNibble(rom[word * 2]);
+        const u8 y = GetLeftNibble(rom[word * 2 + 1]);
+
+        if (reads(opcode, x, y) & VF) {
+            return false;
+        }
+
+        if (writes(opcode, x) & VF) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// [start, end) is a block that ends in its only jump or return. The registers start out unknown.
+// The values tracked are the optimized program's: they only differ from the original's in VF,
+// right after a folded Fx1E, and it's overwritten before it's read then.
+static void compact(Result& result, u32 start, u32 end) {
+    std::vector<u8>& rom = result.rom;
+    std::array<bool, 16> known = {};
+    std::array<u8, 16> value = {};
+    bool iKnown = false;
+    u16 iValue = 0;
+    i32 iSetter = -1;       // The Annn that set I, while I hasn't been used since
+    std::vector<u32> kept;
+
+    for (u32 word = start; word < end - 1; ++word) {
+        const OPCODE opcode = opcodeOf(rom, word);
+        const u8 x = GetRightNibble(rom[word * 2]);
+        const u8 y = GetLeftNibble(rom[word * 2 + 1]);
+        const u8 nn = rom[word * 2 + 1];
+        const u16 nnn = targetOf(rom, word);
+        bool drop = false;
+
+        switch (opcode) {
+        case OP_LD:
+            drop = known[x] && value[x] == nn;
+            known[x] = true;
+            value[x] = nn;
+            break;
+
+        case OP_ADD:
+            value[x] += nn;
+            break;
+
+        case OP_LD_V:
+            known[x] = known[y];
+            value[x] = value[y];
+            break;
+
+        case OP_LD_I:
+            drop = iKnown && iValue == nnn;
+
+            if (!drop) {
+                iKnown = true;
+                iValue = nnn;
+                iSetter = i32(word);
+            }
+            break;
+
+        case OP_ADD_I:
+            if (iKnown && known[x] && iSetter >= 0 && iValue + value[x] <= 0xfff && vfDead(rom, word + 1, end)) {
+                iValue += value[x];
+                rom[iSetter * 2] = u8(0xa0 | iValue >> 8);
+                rom[iSetter * 2 + 1] = u8(iValue);
+                drop = true;
+                ++result.folded;
+                break;
+            }
+
+            known[0xf] = iKnown && known[x];
+            value[0xf] = iValue + value[x] > 0xfff;
+            iValue = u16(iValue + value[x]);
+            iKnown = known[0xf];
+            iSetter = -1;
+            break;
+
+        default:
+            for (u8 v = 0; v < 16; ++v) {
+                if (writes(opcode, x) & (1u << v)) {
+                    known[v] = false;
+                }
+            }
+
+            if (opcode == OP_CALL || opcode == OP_LD_F) {
+                iKnown = false;
+            }
+
+            if (opcode == OP_CALL || opcode == OP_LD_F || opcode == OP_DRW || opcode == OP_LD_B
+                || opcode == OP_LD_I_V || opcode == OP_LD_V_I) {
+                iSetter = -1;
+            }
+            break;
+        }
+
+        if (drop) {
+            result.saved[word] = 1;
+            result.removed += opcode != OP_ADD_I;
+        } else {
+            kept.push_back(word);
+        }
+    }
+
+    if (kept.size() == end - 1 - start) {
+        return;
+    }
+
+    // Moving up never overwrites a word that's still to be moved, & the end fills the rest.
+    kept.push_back(end - 1);
+    u32 to = start;
+
+    for (u32 word: kept) {
+        rom[to * 2] = rom[word * 2];
+        rom[to * 2 + 1] = rom[word * 2 + 1];
+        ++to;
+    }
+
+    for (; to < end; ++to) {
+        rom[to * 2] = rom[(end - 1) * 2];
+        rom[to * 2 + 1] = rom[(end - 1) * 2 + 1];
+    }
+}
+
+
+// Optimizer
+
+optimizer::Result optimizer::Optimize(const std::vector<u8>& rom) {
+    Analysis analysis = {rom, u32(rom.size() / 2), std::vector<u8>(rom.size() / 2), {}};
+    Result result;
+
+    result.rom = rom;
+    result.saved.resize(analysis.words);
+    analyse(analysis);
+
+    // Code running off the grid of words can't be told apart from data.
+    if (analysis.misaligned) {
+        return result;
+    }
+
+    thread(analysis, result);
+
+    for (u32 start = 0; start < analysis.words;) {
+        if (!(analysis.flags[start] & FLAG_CODE)) {
+            ++start;
+            continue;
+        }
+
+        u32 end = start;
+        bool movable = true;
+
+        for (;; ++end) {
+            const OPCODE opcode = opcodeOf(result.rom, end);
+
+            movable &= !(analysis.flags[end] & FLAG_FIXED) && !isSkip(opcode);
+
+            if (isTerminator(opcode)) {
+                break;
+            }
+
+            if (end + 1 == analysis.words || (analysis.flags[end + 1] & (FLAG_CODE | FLAG_LEADER)) != FLAG_CODE) {
+                movable = false;    // Falls through into the next block
+                break;
+            }
+        }
+
+        if (movable) {
+            compact(result, start, end + 1);
+        }
+
+        start = end + 1;
+    }
+
+    return result;
+}
@@ -0,0 +1,36 @@
+#ifndef GOGA_TAMAS_CHIP_8_OPTIMIZER_HPP
+#define GOGA_TAMAS_CHIP_8_OPTIMIZER_HPP
+
+#include <vector>
+#include "instructions.hpp"
+
+// ROM optimizer: rewrites a ROM so that it executes fewer instructions to do the same thing.
+// Nothing moves across basic blocks, so the ROM keeps its size & every address that's jumped to or read stays put.
+//
+// Rewrites:
+// - Jump threading: JP & CALL to a JP go straight to the end of the chain, and JP to a RET becomes the RET.
+// - Within basic blocks that end in a jump or a return (and have no skips), where the registers are tracked:
+//   reloading a register or I with the value it already holds is removed,
+//   and Fx1E on a known I & Vx is folded into the Annn before it, if VF is overwritten before it's read.
+//   What's left of the block moves up, & its end is repeated in the words that are freed.
+//
+// Left alone, as they can't be analysed:
+// - Anything reachable through Bnnn: every word in reach of nnn + V0 is taken as an entry point, & never changed.
+// - Everything from the lowest address an Annn points into the ROM on. I only starts out at Annn (or in the font),
+//   and only grows through Fx1E, so that's where sprites & data are read, and where self-modifying stores go.
+
+namespace ch8 {
+    namespace optimizer {
+        struct Result {
+            std::vector<u8> rom;        // The same size as the original
+            std::vector<u8> saved;      // Per word of the original: instructions saved every time it's executed
+            u32 threaded = 0;           // Jumps & calls sent to the end of their chain
+            u32 removed  = 0;           // Reloads of a known value
+            u32 folded   = 0;           // Fx1E folded into Annn
+        };
+
+        Result Optimize(const std::vector<u8>& rom);
+    }
+}
+
+#endif // GOGA_TAMAS_CHIP_8_OPTIMIZER_HPP
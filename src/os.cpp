@@ -1,6 +1,15 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
-#include <fstream>
+#include <algorithm>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "os.hpp"
+#include "export.hpp"
+#include "terminal.hpp"
 
 // Arguments
 
@@ -20,49 +29,161 @@ os::Arguments::Arguments(int count, char** args) {
             options |= ch8::OPTIONS_CODE;
         } else if (strcmp("noexec", args[i]) == 0) {
             options |= ch8::OPTIONS_NOEXEC;
+        } else if (strcmp("aot", args[i]) == 0) {
+            options |= ch8::OPTIONS_AOT;
+        } else if (strcmp("phosphor", args[i]) == 0) {
+            options |= ch8::OPTIONS_PHOSPHOR;
+        } else if (strcmp("turbo", args[i]) == 0) {
+            options |= ch8::OPTIONS_TURBO;
+        } else if (strncmp("turbo=", args[i], 6) == 0) {
+            options |= ch8::OPTIONS_TURBO;
+            speed = strtoul(args[i] + 6, nullptr, 10);
+        } else if (strncmp("record=", args[i], 7) == 0) {
+            options |= ch8::OPTIONS_RECORD;
+            golden = args[i] + 7;
+        } else if (strncmp("verify=", args[i], 7) == 0) {
+            options |= ch8::OPTIONS_VERIFY;
+            golden = args[i] + 7;
+        } else if (strncmp("frames=", args[i], 7) == 0) {
+            frames = strtoul(args[i] + 7, nullptr, 10);
+        } else if (strncmp("trace=", args[i], 6) == 0) {
+            options |= ch8::OPTIONS_TRACE;
+            trace = args[i] + 6;
+        } else if (strcmp("compress", args[i]) == 0) {
+            options |= ch8::OPTIONS_COMPRESS;
+        } else if (strcmp("debug", args[i]) == 0) {
+            options |= ch8::OPTIONS_DEBUG;
+        } else if (strncmp("y4m=", args[i], 4) == 0 || strncmp("pbm=", args[i], 4) == 0 || strncmp("ppm=", args[i], 4) == 0) {
+            options |= ch8::OPTIONS_EXPORT;
+            format = args[i][0] == 'y' ? ch8::EXPORT_Y4M : args[i][1] == 'b' ? ch8::EXPORT_PBM : ch8::EXPORT_PPM;
+            output = args[i] + 4;
+        } else if (strcmp("changed", args[i]) == 0) {
+            options |= ch8::OPTIONS_CHANGED;
+        } else if (strcmp("serve", args[i]) == 0) {
+            options |= ch8::OPTIONS_SERVE;
+        } else if (strncmp("publish=", args[i], 8) == 0) {
+            options |= ch8::OPTIONS_PUBLISH;
+            publish = args[i] + 8;
+        } else if (strncmp("tiles=", args[i], 6) == 0) {
+            options |= ch8::OPTIONS_TILES;
+            tiles = strtoul(args[i] + 6, nullptr, 10);
+        } else if (strcmp("startup-trace", args[i]) == 0 || strcmp("--startup-trace", args[i]) == 0) {
+            options |= ch8::OPTIONS_STARTUP;
+        } else if (strncmp("optimize=", args[i], 9) == 0) {
+            options |= ch8::OPTIONS_OPTIMIZE;
+            optimized = args[i] + 9;
+        } else if (strcmp("term", args[i]) == 0 || strcmp("term=half", args[i]) == 0) {
+            options |= ch8::OPTIONS_TERMINAL;
+            glyphs = ch8::terminal::GLYPHS_HALF;
+        } else if (strcmp("latency", args[i]) == 0) {
+            options |= ch8::OPTIONS_LATENCY;
+        } else if (strcmp("term=braille", args[i]) == 0) {
+            options |= ch8::OPTIONS_TERMINAL;
+            glyphs = ch8::terminal::GLYPHS_BRAILLE;
         }
     }
 }
 
 // Files
 
-static std::string fileError;
+// One pread into the caller's buffer, so loads share nothing & allocate nothing.
+os::LoadResult os::LoadChip8File(const char* path, RomBuffer& buffer) noexcept {
+    LoadResult result;
+    const int fd = open(path, O_RDONLY | O_CLOEXEC);
 
-// Not optimal, since we will have to parse the vector again.
-// Good enough, though, considering these programs should be less than 4KB.
-std::vector<u8> os::ReadChip8File(std::string path) {   
-    using std::vector;
-    using std::to_string;
-     
-    fileError.clear();
-    std::ifstream file(path, std::ios::binary);
+    if (fd < 0) {
+        result.error = LOAD_OPEN;
+        result.code = errno;
+        return result;
+    }
+
+    struct stat info = {};
+
+    if (fstat(fd, &info) != 0 || S_ISDIR(info.st_mode)) {
+        result.error = LOAD_READ;
+        result.code = S_ISDIR(info.st_mode) ? EISDIR : errno;
+        close(fd);
+        return result;
+    }
+
+    // Plenty of ROMs (Trip8, for one) end in an odd data byte, the instructions are still aligned.
+    // MAX_PROG_LEN is even, so the padding never makes a ROM too large.
+    result.length = u32(std::min<off_t>(info.st_size, ch8::MAX_PROG_LEN + 1));
+
+    if (result.length > ch8::MAX_PROG_LEN) {
+        result.error = LOAD_TOO_LARGE;
+        result.length = 0;
+        close(fd);
+        return result;
+    }
+
+    for (u32 read = 0; read < result.length;) {
+        const ssize_t count = pread(fd, buffer.data() + read, result.length - read, read);
+
+        if (count <= 0) {
+            result.error = LOAD_READ;
+            result.code = count < 0 ? errno : EIO;
+            result.length = 0;
+            close(fd);
+            return result;
+        }
 
-    if (!file.is_open()) {
-        fileError = strerror(errno);
-        return vector<u8>();
+        read += u32(count);
     }
 
-    // https://stackoverflow.com/questions/5420317/reading-and-writing-binary-file
-    auto bytes = vector<u8>(std::istreambuf_iterator<char>(file), {});
-    auto len = bytes.size();
+    close(fd);
+    result.size = result.length;
 
-    if (len % 2 != 0) {
-        fileError = "The program should have an even amount of bytes";
-        return vector<u8>();
+    if (result.length % 2 != 0) {
+        buffer[result.length++] = 0;
     }
 
-    if (len > ch8::MAX_PROG_LEN) {
-        fileError = "The program is too large (" + to_string(len) + " > " + to_string(ch8::MAX_PROG_LEN) + ")";
-        return vector<u8>();
+    return result;
+}
+
+std::string os::LoadResult::Message() const {
+    switch (error) {
+    case LOAD_OK:
+        return "";
+    case LOAD_TOO_LARGE:
+        return "The program is too large (> " + std::to_string(ch8::MAX_PROG_LEN) + " bytes)";
+
+    default:
+        return std::generic_category().message(code);
     }
+}
+
+// Terminal
+
+bool os::IsInteractive() noexcept {
+    return isatty(STDIN_FILENO);
+}
+
+// Startup timeline
 
-    return bytes;
+using startup_clock = std::chrono::steady_clock;
+
+static const startup_clock::time_point processStart = startup_clock::now();
+static startup_clock::time_point lastMilestone = processStart;
+static bool tracingStartup = false;
+
+void os::TraceStartup() noexcept {
+    tracingStartup = true;
 }
 
-bool os::HasFileError() noexcept {
-    return !fileError.empty();
+void os::Mark(const char* milestone) noexcept {
+    if (!tracingStartup) {
+        return;
+    }
+
+    using ms = std::chrono::duration<double, std::milli>;
+    const auto now = startup_clock::now();
+
+    fprintf(stderr, "startup %9.3f ms  (+%8.3f)  %s\n", ms(now - processStart).count(), ms(now - lastMilestone).count(), milestone);
+    lastMilestone = now;
 }
 
-const std::string& os::GetFileError() noexcept {
-    return fileError;
+void os::MarkLast(const char* milestone) noexcept {
+    Mark(milestone);
+    tracingStartup = false;
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #ifndef GOGA_TAMAS_CHIP_8_OS_HPP
 #define GOGA_TAMAS_CHIP_8_OS_HPP
 
+#include <array>
 #include <string>
 #include <vector>
 #include "defines.hpp"
@@ -11,6 +12,16 @@ namespace os {
     struct Arguments {
         u32         options = 0;
         std::string path    = "";
+        u32         speed   = 0;    // Emulated frames per displayed frame while fast-forwarding, 0 is uncapped
+        std::string golden  = "";   // Golden trace to record or verify against
+        u32         frames  = 36000; // Length of recorded golden traces (10 minutes)
+        std::string trace   = "";   // Execution trace to record
+        std::string output  = "";   // Where exported frames go
+        u32         format  = 0;    // Of exported frames, see export.hpp
+        std::string publish = "";   // Name of the shared memory to publish the machine in
+        u32         tiles   = 0;    // Machines to run side by side in the tiled view
+        std::string optimized = ""; // Where the optimized ROM goes
+        u32         glyphs  = 0;    // Of the terminal frontend, see terminal.hpp
 
         Arguments(int count, char** args);
 
@@ -24,14 +35,42 @@ namespace os {
         }
     };
 
-    // We will assume that the file can be stored in memory all at once.
-    // Also, the program cannot have an odd number of bytes, as per the spec.
-    // It must also fit within Chip-8's memory constraints.
-    std::vector<u8> ReadChip8File(std::string path);
+    // ROMs are read into a buffer the caller owns, large enough for any ROM that fits in Chip-8's memory.
+    using RomBuffer = std::array<u8, ch8::MAX_PROG_LEN>;
 
-    // File error handling.
-    bool               HasFileError() noexcept;
-    const std::string& GetFileError() noexcept;
+    enum LOAD_ERROR: u32 {
+        LOAD_OK = 0,
+        LOAD_OPEN,          // The file couldn't be opened, see code
+        LOAD_READ,          // Or read, see code
+        LOAD_TOO_LARGE      // It doesn't fit in memory
+    };
+
+    struct LoadResult {
+        LOAD_ERROR error  = LOAD_OK;
+        int        code   = 0;      // errno, for LOAD_OPEN & LOAD_READ
+        u32        length = 0;      // Bytes of the ROM in the buffer, 0 on failure
+        u32        size   = 0;      // Of the file: one less than length, if the ROM was padded
+
+        bool Ok() const noexcept {
+            return error == LOAD_OK;
+        }
+
+        std::string Message() const;
+    };
+
+    // Reads a ROM into the buffer. The program cannot have an odd number of bytes, as per the spec:
+    // odd ROMs are padded with a zero. Keeps no state, so any number of threads may load at once.
+    LoadResult LoadChip8File(const char* path, RomBuffer& buffer) noexcept;
+
+    // Whether stdin is a terminal, rather than a script.
+    bool IsInteractive() noexcept;
+
+    // Startup timeline: once traced, every milestone is printed to stderr, with the time since the process started
+    // (static initialization, to be exact) & since the previous milestone. Marks are no-ops otherwise.
+    // The last milestone ends the trace, so it can be marked in a loop.
+    void TraceStartup() noexcept;
+    void Mark(const char* milestone) noexcept;
+    void MarkLast(const char* milestone) noexcept;
 }
 
 #endif // GOGA_TAMAS_CHIP_8_OS_HPP
\ No newline at end of file
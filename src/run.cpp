@@ -0,0 +1,100 @@
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include "chip8.hpp"
+#include "latency.hpp"
+#include "sdl.hpp"
+
+// The interactive run loop, the only part of Program that needs SDL (so the core builds without it, see libchip8.h).
+
+// While fast-forwarding, the timers still tick once per emulated frame, only the display is skipped:
+// at N times the speed, every Nth frame is shown; uncapped, the frames fill the time until the next refresh.
+void ch8::Program::Execute() {
+    using clock = std::chrono::steady_clock;
+    const auto refresh = std::chrono::microseconds(1000000 / FRAME_RATE);
+
+    if (interface == nullptr) {
+        throw std::runtime_error("A headless program can't be executed");
+    }
+
+    Load();
+    state.seed = u32(clock::now().time_since_epoch().count()) | 1u;
+
+    interface->scaler.phosphor = arguments.IsEnabled(OPTIONS_PHOSPHOR);
+    interface->turbo = arguments.IsEnabled(OPTIONS_TURBO);
+
+    std::unique_ptr<Latency> latency;
+    if (arguments.IsEnabled(OPTIONS_LATENCY)) {
+        latency = std::make_unique<Latency>();
+        interface->latency = latency.get();
+    }
+
+    // If start doesn't throw, we're guaranteed to have SDL set up correctly (otherwise main reports it).
+    interface->Start("Chip-8", 800, 600);
+    interface->ClearScreen();
+    os::Mark("Window cleared");
+
+    auto deadline = clock::now();
+
+    while (interface->PollEvents(state.keys)) {
+        deadline += refresh;
+
+        if (latency) {
+            latency->Started(state);
+        }
+
+        if (!interface->turbo) {
+            RunFrame();
+        } else if (arguments.speed != 0) {
+            for (u32 n = 0; n < arguments.speed; ++n) {
+                RunFrame();
+            }
+        } else {
+            do {
+                RunFrame();
+            } while (clock::now() < deadline);
+        }
+
+        if (latency) {
+            latency->Finished(state);
+        }
+
+        interface->Draw(&state.memory[SCREEN_START]);
+        os::MarkLast("First frame presented");
+
+        if (latency) {
+            latency->Presented();
+        }
+
+        if (state.st > 0) {
+            interface->Beep();
+        }
+
+        // Don't try to catch up after a stall (or while fast-forwarding faster than we can).
+        auto now = clock::now();
+        if (now > deadline) {
+            deadline = now;
+        }
+
+        // Once idle & silent, nothing changes until a key does: sleep until there's an event,
+        // then skip the frames in between. Phosphor still has pixels to fade, though.
+        if (Idle() && state.st == 0 && !interface->turbo && !interface->scaler.phosphor) {
+            interface->WaitEvents();
+
+            now = clock::now();
+            if (now > deadline) {
+                RunFrames(u32((now - deadline) / refresh));
+                deadline = now;
+            }
+        }
+
+        std::this_thread::sleep_until(deadline);
+    }
+
+    interface->Stop();
+
+    if (latency) {
+        interface->latency = nullptr;
+        latency->Report(stderr);
+    }
+}
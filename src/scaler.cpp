@@ -0,0 +1,261 @@
+#include <cstring>
+#include "scaler.hpp"
+
+// All x86-64 CPUs have SSE2, AVX2 is picked at runtime.
+#if defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define CH8_SCALER_SIMD
+#endif
+
+static constexpr u32 ROW_BYTES = ch8::SCREEN_WIDTH / 8;
+
+// The work is split into three kernels:
+// shade:   turns a row of bits into a row of colours,
+// fade:    updates the phosphor intensity of a row of pixels,
+// stretch: repeats each colour of a row factor times.
+// Vertical scaling is done by copying the first line of each row.
+
+namespace {
+    struct Kernels {
+        void (*shade)(const u8* row, u32 on, u32 off, u32* colors) noexcept;
+        void (*fade)(const u8* row, u8* intensity, u8 decay) noexcept;
+        void (*stretch)(const u32* colors, u32* line, u32 factor) noexcept;
+    };
+}
+
+// The ends of the palette are exactly off & on, so it only has to be rebuilt when those change.
+static void buildPalette(ch8::Scaler& scaler) noexcept {
+    if (scaler.palette[0] == scaler.off && scaler.palette[255] == scaler.on) {
+        return;
+    }
+
+    for (i32 t = 0; t < 256; ++t) {
+        u32 color = 0;
+
+        for (u32 shift = 0; shift < 32; shift += 8) {
+            i32 from = (scaler.off >> shift) & 0xff;
+            i32 to   = (scaler.on >> shift) & 0xff;
+
+            color |= u32(from + (to - from) * t / 255) << shift;
+        }
+
+        scaler.palette[t] = color;
+    }
+}
+
+
+// Scalar
+
+static void shadeScalar(const u8* row, u32 on, u32 off, u32* colors) noexcept {
+    for (u32 x = 0; x < ch8::SCREEN_WIDTH; ++x) {
+        colors[x] = row[x / 8] & (0x80 >> (x % 8)) ? on : off;
+    }
+}
+
+static void fadeScalar(const u8* row, u8* intensity, u8 decay) noexcept {
+    for (u32 x = 0; x < ch8::SCREEN_WIDTH; ++x) {
+        bool lit = row[x / 8] & (0x80 >> (x % 8));
+        intensity[x] = lit ? 0xff : u8((intensity[x] * decay) >> 8);
+    }
+}
+
+static void stretchScalar(const u32* colors, u32* line, u32 factor) noexcept {
+    for (u32 x = 0; x < ch8::SCREEN_WIDTH; ++x) {
+        for (u32 k = 0; k < factor; ++k) {
+            *line++ = colors[x];
+        }
+    }
+}
+
+
+// SSE2 & AVX2
+
+#ifdef CH8_SCALER_SIMD
+static void shadeSse2(const u8* row, u32 on, u32 off, u32* colors) noexcept {
+    const __m128i high = _mm_set_epi32(0x10, 0x20, 0x40, 0x80);
+    const __m128i low  = _mm_set_epi32(0x01, 0x02, 0x04, 0x08);
+    const __m128i lit  = _mm_set1_epi32(i32(on));
+    const __m128i dark = _mm_set1_epi32(i32(off));
+
+    for (u32 b = 0; b < ROW_BYTES; ++b) {
+        const __m128i bits = _mm_set1_epi32(row[b]);
+        const __m128i left  = _mm_cmpeq_epi32(_mm_and_si128(bits, high), high);
+        const __m128i right = _mm_cmpeq_epi32(_mm_and_si128(bits, low), low);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(colors + b * 8),
+                         _mm_or_si128(_mm_and_si128(left, lit), _mm_andnot_si128(left, dark)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(colors + b * 8 + 4),
+                         _mm_or_si128(_mm_and_si128(right, lit), _mm_andnot_si128(right, dark)));
+    }
+}
+
+// 16 pixels at a time: scale the intensities down, then saturate the lit ones.
+static void fadeSse2(const u8* row, u8* intensity, u8 decay) noexcept {
+    const __m128i pattern = _mm_set_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    const __m128i factor  = _mm_set1_epi16(decay);
+    const __m128i zero    = _mm_setzero_si128();
+
+    for (u32 b = 0; b < ROW_BYTES; b += 2) {
+        const __m128i bits = _mm_unpacklo_epi64(_mm_set1_epi8(i8(row[b])), _mm_set1_epi8(i8(row[b + 1])));
+        const __m128i lit  = _mm_cmpeq_epi8(_mm_and_si128(bits, pattern), pattern);
+
+        __m128i* target = reinterpret_cast<__m128i*>(intensity + b * 8);
+        const __m128i current = _mm_loadu_si128(target);
+        const __m128i low  = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(current, zero), factor), 8);
+        const __m128i high = _mm_srli_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(current, zero), factor), 8);
+
+        _mm_storeu_si128(target, _mm_or_si128(_mm_packus_epi16(low, high), lit));
+    }
+}
+
+static void stretchSse2(const u32* colors, u32* line, u32 factor) noexcept {
+    for (u32 x = 0; x < ch8::SCREEN_WIDTH; ++x, line += factor) {
+        const __m128i color = _mm_set1_epi32(i32(colors[x]));
+        u32 k = 0;
+
+        for (; k + 4 <= factor; k += 4) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(line + k), color);
+        }
+
+        for (; k < factor; ++k) {
+            line[k] = colors[x];
+        }
+    }
+}
+
+__attribute__((target("avx2")))
+static void shadeAvx2(const u8* row, u32 on, u32 off, u32* colors) noexcept {
+    const __m256i pattern = _mm256_set_epi32(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80);
+    const __m256i lit     = _mm256_set1_epi32(i32(on));
+    const __m256i dark    = _mm256_set1_epi32(i32(off));
+
+    for (u32 b = 0; b < ROW_BYTES; ++b) {
+        const __m256i bits = _mm256_set1_epi32(row[b]);
+        const __m256i mask = _mm256_cmpeq_epi32(_mm256_and_si256(bits, pattern), pattern);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(colors + b * 8), _mm256_blendv_epi8(dark, lit, mask));
+    }
+}
+
+__attribute__((target("avx2")))
+static void fadeAvx2(const u8* row, u8* intensity, u8 decay) noexcept {
+    constexpr u64 SPREAD = 0x0101010101010101ull;
+
+    const __m256i pattern = _mm256_set1_epi64x(i64(0x0102040810204080ull));
+    const __m256i factor  = _mm256_set1_epi16(decay);
+    const __m256i zero    = _mm256_setzero_si256();
+
+    for (u32 b = 0; b < ROW_BYTES; b += 4) {
+        const __m256i bits = _mm256_set_epi64x(i64(row[b + 3] * SPREAD), i64(row[b + 2] * SPREAD),
+                                               i64(row[b + 1] * SPREAD), i64(row[b] * SPREAD));
+        const __m256i lit  = _mm256_cmpeq_epi8(_mm256_and_si256(bits, pattern), pattern);
+
+        __m256i* target = reinterpret_cast<__m256i*>(intensity + b * 8);
+        const __m256i current = _mm256_loadu_si256(target);
+        const __m256i low  = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(current, zero), factor), 8);
+        const __m256i high = _mm256_srli_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(current, zero), factor), 8);
+
+        _mm256_storeu_si256(target, _mm256_or_si256(_mm256_packus_epi16(low, high), lit));
+    }
+}
+
+__attribute__((target("avx2")))
+static void stretchAvx2(const u32* colors, u32* line, u32 factor) noexcept {
+    for (u32 x = 0; x < ch8::SCREEN_WIDTH; ++x, line += factor) {
+        const __m256i color = _mm256_set1_epi32(i32(colors[x]));
+        u32 k = 0;
+
+        for (; k + 8 <= factor; k += 8) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(line + k), color);
+        }
+
+        if (k + 4 <= factor) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(line + k), _mm256_castsi256_si128(color));
+            k += 4;
+        }
+
+        for (; k < factor; ++k) {
+            line[k] = colors[x];
+        }
+    }
+}
+#endif
+
+static Kernels selectKernels() noexcept {
+#ifdef CH8_SCALER_SIMD
+    if (__builtin_cpu_supports("avx2")) {
+        return {shadeAvx2, fadeAvx2, stretchAvx2};
+    }
+
+    return {shadeSse2, fadeSse2, stretchSse2};
+#else
+    return {shadeScalar, fadeScalar, stretchScalar};
+#endif
+}
+
+
+// Scaler
+
+void ch8::Scaler::Expand(const u8* screen, void* pixels, i32 pitch) noexcept {
+    static const Kernels kernels = selectKernels();
+
+    if (phosphor) {
+        buildPalette(*this);
+    }
+
+    const u32 bytes = SCREEN_WIDTH * factor * sizeof(u32);
+    u32 colors[SCREEN_WIDTH];
+
+    for (u32 y = 0; y < SCREEN_HEIGHT; ++y) {
+        const u8* row = screen + y * ROW_BYTES;
+        u8* first = static_cast<u8*>(pixels) + y * factor * pitch;
+
+        if (phosphor) {
+            u8* fading = &intensity[y * SCREEN_WIDTH];
+            kernels.fade(row, fading, decay);
+
+            for (u32 x = 0; x < SCREEN_WIDTH; ++x) {
+                colors[x] = palette[fading[x]];
+            }
+        } else {
+            kernels.shade(row, on, off, colors);
+        }
+
+        if (factor == 1) {
+            memcpy(first, colors, bytes);
+        } else {
+            kernels.stretch(colors, reinterpret_cast<u32*>(first), factor);
+        }
+
+        for (u32 k = 1; k < factor; ++k) {
+            memcpy(first + k * pitch, first, bytes);
+        }
+    }
+}
+
+void ch8::Scaler::ExpandScalar(const u8* screen, void* pixels, i32 pitch) noexcept {
+    if (phosphor) {
+        buildPalette(*this);
+    }
+
+    u32 colors[SCREEN_WIDTH];
+
+    for (u32 y = 0; y < SCREEN_HEIGHT; ++y) {
+        const u8* row = screen + y * ROW_BYTES;
+
+        if (phosphor) {
+            u8* fading = &intensity[y * SCREEN_WIDTH];
+            fadeScalar(row, fading, decay);
+
+            for (u32 x = 0; x < SCREEN_WIDTH; ++x) {
+                colors[x] = palette[fading[x]];
+            }
+        } else {
+            shadeScalar(row, on, off, colors);
+        }
+
+        for (u32 k = 0; k < factor; ++k) {
+            stretchScalar(colors, reinterpret_cast<u32*>(static_cast<u8*>(pixels) + (y * factor + k) * pitch), factor);
+        }
+    }
+}
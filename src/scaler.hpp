@@ -0,0 +1,30 @@
+#ifndef GOGA_TAMAS_CHIP_8_SCALER_HPP
+#define GOGA_TAMAS_CHIP_8_SCALER_HPP
+
+#include <array>
+#include "defines.hpp"
+
+// Expands the bit-packed display into 32-bit ARGB pixels, scaled up by an integer factor (nearest neighbour).
+// Uses SSE2, or AVX2 if the CPU has it. Everything else gets the scalar version.
+
+namespace ch8 {
+    struct Scaler {
+        u32  factor   = 1;
+        u32  on       = 0xffffffffu;    // Colour of lit pixels
+        u32  off      = 0xff000000u;    // Colour of unlit pixels
+        bool phosphor = false;          // Lets pixels fade out over a few frames, instead of flickering
+        u8   decay    = 160;            // Intensity kept by unlit pixels each frame, out of 256
+
+        // Writes (SCREEN_WIDTH * factor) x (SCREEN_HEIGHT * factor) pixels, with rows pitch bytes apart.
+        void Expand(const u8* screen, void* pixels, i32 pitch) noexcept;
+
+        // Does the same, one pixel at a time. For reference & benchmarking.
+        void ExpandScalar(const u8* screen, void* pixels, i32 pitch) noexcept;
+
+        // Phosphor state: the intensity of every pixel, and the colours in between off & on.
+        std::array<u8, SCREEN_WIDTH * SCREEN_HEIGHT> intensity = {};
+        std::array<u32, 256>                         palette   = {};
+    };
+}
+
+#endif // GOGA_TAMAS_CHIP_8_SCALER_HPP
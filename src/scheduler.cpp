@@ -0,0 +1,38 @@
+#include "scheduler.hpp"
+
+// C-tors
+
+ch8::Scheduler::Scheduler(Interface& interface)
+    : interface(interface)
+{}
+
+u32 ch8::Scheduler::Add(const char* path, u32 options, u32 seed) {
+    sessions.push_back(std::make_unique<Session>(interface, path, options));
+
+    Session& session = *sessions.back();
+    session.program.Load();
+    session.state.seed = seed | 1u;
+
+    return u32(sessions.size() - 1);
+}
+
+
+// Running
+
+// A parked machine's frame would execute Fx0A over & over, then tick the timers: only the last part changes anything.
+// The frames it skips aren't observed for idle detection, which is safe: it only wakes up once the keys change,
+// and a change of keys ends being idle anyway.
+void ch8::Scheduler::Tick() noexcept {
+    waiting = 0;
+
+    for (auto& session: sessions) {
+        if (session->parked && session->state.keys == 0) {
+            session->state.TickTimers();
+        } else {
+            session->program.RunFrame();
+            session->parked = session->program.Waiting();
+        }
+
+        waiting += session->parked;
+    }
+}
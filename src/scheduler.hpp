@@ -0,0 +1,56 @@
+#ifndef GOGA_TAMAS_CHIP_8_SCHEDULER_HPP
+#define GOGA_TAMAS_CHIP_8_SCHEDULER_HPP
+
+#include <memory>
+#include <vector>
+#include "chip8.hpp"
+
+// Runs any number of machines on the calling thread, taking turns a frame at a time.
+// A machine's turn ends at the frame boundary, so switching between machines costs nothing but a function call.
+// Machines blocked on Fx0A (see Program::Waiting) are parked: until a key is held down, their turn only ticks the timers.
+// Idle machines are cheap as it is, see Program::Idle.
+
+namespace ch8 {
+    class Scheduler {
+    public:
+        explicit Scheduler(Interface& interface);
+
+        // Adds a machine running the ROM at the path, loaded & seeded. Returns its slot.
+        // Check that the ROM loads with a Program first.
+        u32 Add(const char* path, u32 options, u32 seed);
+
+        Chip8& State(u32 slot) noexcept {
+            return sessions[slot]->state;
+        }
+
+        std::size_t Size() const noexcept {
+            return sessions.size();
+        }
+
+        // How many machines were parked on Fx0A at the end of the last tick.
+        u32 Waiting() const noexcept {
+            return waiting;
+        }
+
+        // Gives every machine its turn: one frame each.
+        void Tick() noexcept;
+
+    private:
+        // One machine taking turns, & whether the last tick left it parked on Fx0A (see Tick).
+        struct Session: CacheAligned {
+            Chip8   state;
+            Program program;
+            bool    parked = false;
+
+            Session(Interface& interface, const char* path, u32 options)
+                : program(state, interface, path, options)
+            {}
+        };
+
+        Interface& interface;
+        std::vector<std::unique_ptr<Session>> sessions;
+        u32 waiting = 0;
+    };
+}
+
+#endif // GOGA_TAMAS_CHIP_8_SCHEDULER_HPP
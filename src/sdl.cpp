@@ -1,17 +1,23 @@
+#include <algorithm>
 #include <stdexcept>
+#include "os.hpp"
+#include "latency.hpp"
 #include "sdl.hpp"
 
 // Starting & stopping SDL is done statically, since we only want to do those operations once.
+// Subsystems are only started when they're first needed: disassembling or a headless run never touches SDL,
+// and the audio device isn't opened until something beeps.
 
 static u32 interfaceCount = 0u;
+static bool noAudio = false;    // Starting the audio failed once, so beeps are dropped instead of retrying every frame
 
-static inline void startSDL() {
-    if (interfaceCount > 0u || SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_EVENTS) == 0) {
-        ++interfaceCount;
-        return;
-    }
+static inline void startSDL() noexcept {
+    ++interfaceCount;
+}
 
-    throw std::runtime_error(SDL_GetError());
+// Returns false if the subsystems couldn't be started.
+static inline bool requireSDL(u32 subsystems) noexcept {
+    return SDL_WasInit(subsystems) == subsystems || SDL_InitSubSystem(subsystems) == 0;
 }
 
 static inline void stopSDL() noexcept {
@@ -21,7 +27,10 @@ static inline void stopSDL() noexcept {
     }
 
     interfaceCount = 0u;
-    SDL_Quit();
+
+    if (SDL_WasInit(0) != 0) {
+        SDL_Quit();
+    }
 }
 
 
@@ -44,8 +53,17 @@ ch8::Interface::Interface(const Interface& other) {
 ch8::Interface& ch8::Interface::operator=(const Interface& other) {
     startSDL();
 
+    turbo = other.turbo;
+    latency = other.latency;
+    scaler = other.scaler;
+
     if (other.window != nullptr) {
         i32 x, y, w, h;
+
+        if (!requireSDL(SDL_INIT_VIDEO | SDL_INIT_EVENTS)) {
+            throw std::runtime_error(SDL_GetError());
+        }
+
         SDL_GetWindowPosition(other.window, &x, &y);
         SDL_GetWindowSize(other.window, &w, &h);
 
@@ -84,17 +102,54 @@ ch8::Interface& ch8::Interface::operator=(Interface&& other) {
     renderer = other.renderer;
     other.renderer = nullptr;
 
+    texture = other.texture;
+    other.texture = nullptr;
+
+    atlas = other.atlas;
+    other.atlas = nullptr;
+
+    audio = other.audio;
+    other.audio = 0;
+
+    turbo = other.turbo;
+    latency = other.latency;
+    scaler = other.scaler;
+    viewport = other.viewport;
+    tiler = other.tiler;
+    tiles = other.tiles;
+    columns = other.columns;
+    rows = other.rows;
+    atlasViewport = other.atlasViewport;
+
     return *this;
 }
 
 void ch8::Interface::Start(const char* title, i32 width, i32 height) {
+    if (!requireSDL(SDL_INIT_VIDEO | SDL_INIT_EVENTS)) {
+        throw std::runtime_error(SDL_GetError());
+    }
+
+    os::Mark("SDL video started");
+
     if (window == nullptr) {
         window = SDL_CreateWindow(title, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, width, height, SDL_WINDOW_SHOWN);
         if (window == nullptr) {
             throw(std::runtime_error(SDL_GetError()));
         }
 
-        // Make sure to delete any previous renderers.
+        os::Mark("Window created");
+
+        // Make sure to delete any previous renderers (& their textures).
+        if (texture != nullptr) {
+            SDL_DestroyTexture(texture);
+            texture = nullptr;
+        }
+
+        if (atlas != nullptr) {
+            SDL_DestroyTexture(atlas);
+            atlas = nullptr;
+        }
+
         if (renderer != nullptr) {
             SDL_DestroyRenderer(renderer);
             renderer = nullptr;
@@ -108,10 +163,27 @@ void ch8::Interface::Start(const char* title, i32 width, i32 height) {
             window = nullptr;
             throw(std::runtime_error(SDL_GetError()));
         }
+
+        os::Mark("Renderer created");
     }
 }
 
 void ch8::Interface::Stop() noexcept {
+    if (audio != 0) {
+        SDL_CloseAudioDevice(audio);
+        audio = 0;
+    }
+
+    if (texture != nullptr) {
+        SDL_DestroyTexture(texture);
+        texture = nullptr;
+    }
+
+    if (atlas != nullptr) {
+        SDL_DestroyTexture(atlas);
+        atlas = nullptr;
+    }
+
     if (renderer != nullptr) {
         SDL_DestroyRenderer(renderer);
         renderer = nullptr;
@@ -121,4 +193,257 @@ void ch8::Interface::Stop() noexcept {
         SDL_DestroyWindow(window);
         window = nullptr;
     }
+}
+
+// The texture & the audio device are created on first use, so copies don't have to care about them.
+
+void ch8::Interface::Draw(const u8* screen) noexcept {
+    if (texture == nullptr) {
+        i32 w, h;
+        if (SDL_GetRendererOutputSize(renderer, &w, &h) != 0) {
+            return;
+        }
+
+        scaler.factor = std::max(1, std::min(w / SCREEN_WIDTH, h / SCREEN_HEIGHT));
+        viewport.w = SCREEN_WIDTH * scaler.factor;
+        viewport.h = SCREEN_HEIGHT * scaler.factor;
+        viewport.x = (w - viewport.w) / 2;
+        viewport.y = (h - viewport.h) / 2;
+
+        texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, viewport.w, viewport.h);
+        if (texture == nullptr) {
+            return;
+        }
+    }
+
+    void* pixels;
+    i32 pitch;
+
+    if (SDL_LockTexture(texture, nullptr, &pixels, &pitch) != 0) {
+        return;
+    }
+
+    scaler.Expand(screen, pixels, pitch);
+
+    SDL_UnlockTexture(texture);
+    SDL_RenderClear(renderer);
+    SDL_RenderCopy(renderer, texture, nullptr, &viewport);
+    SDL_RenderPresent(renderer);
+}
+
+// Tiles have an extra row & column, for the gap between the screens.
+static constexpr u32 TILE_WIDTH  = ch8::SCREEN_WIDTH + 1;
+static constexpr u32 TILE_HEIGHT = ch8::SCREEN_HEIGHT + 1;
+static constexpr u32 GAP_COLOR   = 0xff303030u;
+
+// The atlas is laid out again whenever the count changes. The columns are picked to make the tiles as large as possible;
+// when they fit, they're scaled by an integer factor, so every pixel stays the same size.
+void ch8::Interface::DrawTiles(const u8* const* screens, u32 count) noexcept {
+    if (count == 0) {
+        return;
+    }
+
+    if (atlas == nullptr || tiles != count) {
+        i32 w, h;
+        if (SDL_GetRendererOutputSize(renderer, &w, &h) != 0) {
+            return;
+        }
+
+        float best = 0;
+
+        for (u32 c = 1; c <= count; ++c) {
+            const u32 r = (count + c - 1) / c;
+            const float scale = std::min(float(w) / (c * TILE_WIDTH), float(h) / (r * TILE_HEIGHT));
+
+            if (scale > best) {
+                best = scale;
+                columns = c;
+                rows = r;
+            }
+        }
+
+        if (best >= 1) {
+            best = float(u32(best));
+        }
+
+        if (atlas != nullptr) {
+            SDL_DestroyTexture(atlas);
+        }
+
+        // The gap after the last column & row isn't shown.
+        const i32 atlasWidth  = columns * TILE_WIDTH - 1;
+        const i32 atlasHeight = rows * TILE_HEIGHT - 1;
+
+        atlasViewport.w = i32(atlasWidth * best);
+        atlasViewport.h = i32(atlasHeight * best);
+        atlasViewport.x = (w - atlasViewport.w) / 2;
+        atlasViewport.y = (h - atlasViewport.h) / 2;
+
+        tiler.factor = 1;
+        tiler.on = scaler.on;
+        tiler.off = scaler.off;
+        tiles = count;
+
+        atlas = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, atlasWidth, atlasHeight);
+        if (atlas == nullptr) {
+            return;
+        }
+    }
+
+    void* pixels;
+    i32 pitch;
+
+    if (SDL_LockTexture(atlas, nullptr, &pixels, &pitch) != 0) {
+        return;
+    }
+
+    // A locked texture holds garbage, so the gaps & the empty tiles are filled in every time.
+    for (u32 row = 0; row < rows; ++row) {
+        for (u32 column = 0; column < columns; ++column) {
+            const u32 n = row * columns + column;
+            u8* corner = static_cast<u8*>(pixels) + row * TILE_HEIGHT * pitch + column * TILE_WIDTH * sizeof(u32);
+            const bool lastColumn = column + 1 == columns;
+            const bool lastRow = row + 1 == rows;
+
+            if (n < count) {
+                tiler.Expand(screens[n], corner, pitch);
+            } else {
+                for (u32 y = 0; y < SCREEN_HEIGHT; ++y) {
+                    std::fill_n(reinterpret_cast<u32*>(corner + y * pitch), SCREEN_WIDTH, GAP_COLOR);
+                }
+            }
+
+            if (!lastColumn) {
+                for (u32 y = 0; y < SCREEN_HEIGHT; ++y) {
+                    reinterpret_cast<u32*>(corner + y * pitch)[SCREEN_WIDTH] = GAP_COLOR;
+                }
+            }
+
+            if (!lastRow) {
+                std::fill_n(reinterpret_cast<u32*>(corner + SCREEN_HEIGHT * pitch), TILE_WIDTH - lastColumn, GAP_COLOR);
+            }
+        }
+    }
+
+    SDL_UnlockTexture(atlas);
+    SDL_RenderClear(renderer);
+    SDL_RenderCopy(renderer, atlas, nullptr, &atlasViewport);
+    SDL_RenderPresent(renderer);
+}
+
+void ch8::Interface::Beep() noexcept {
+    constexpr i32 FREQUENCY = 44100;
+    constexpr i32 PITCH     = 440;
+    constexpr u32 SAMPLES   = FREQUENCY / FRAME_RATE;
+
+    if (audio == 0) {
+        if (noAudio || !requireSDL(SDL_INIT_AUDIO)) {
+            noAudio = true;
+            return;
+        }
+
+        SDL_AudioSpec spec = {};
+        spec.freq = FREQUENCY;
+        spec.format = AUDIO_S8;
+        spec.channels = 1;
+        spec.samples = 1024;
+
+        audio = SDL_OpenAudioDevice(nullptr, 0, &spec, nullptr, 0);
+        if (audio == 0) {
+            noAudio = true;
+            return;
+        }
+
+        SDL_PauseAudioDevice(audio, 0);
+    }
+
+    // Don't let the queue grow, if we're running behind.
+    if (SDL_GetQueuedAudioSize(audio) > SAMPLES * 2) {
+        return;
+    }
+
+    static i8 wave[SAMPLES];
+    static u32 phase = 0;
+
+    for (u32 n = 0; n < SAMPLES; ++n, ++phase) {
+        wave[n] = (phase / (FREQUENCY / PITCH / 2)) % 2 ? 32 : -32;
+    }
+
+    SDL_QueueAudio(audio, wave, SAMPLES);
+}
+
+// Keypad layout:   Keyboard:
+// 1 2 3 C          1 2 3 4
+// 4 5 6 D          q w e r
+// 7 8 9 E          a s d f
+// A 0 B F          z x c v
+static i32 mapKey(SDL_Keycode key) noexcept {
+    switch (key) {
+    case SDLK_x: return 0x0;
+    case SDLK_1: return 0x1;
+    case SDLK_2: return 0x2;
+    case SDLK_3: return 0x3;
+    case SDLK_q: return 0x4;
+    case SDLK_w: return 0x5;
+    case SDLK_e: return 0x6;
+    case SDLK_a: return 0x7;
+    case SDLK_s: return 0x8;
+    case SDLK_d: return 0x9;
+    case SDLK_z: return 0xa;
+    case SDLK_c: return 0xb;
+    case SDLK_4: return 0xc;
+    case SDLK_r: return 0xd;
+    case SDLK_f: return 0xe;
+    case SDLK_v: return 0xf;
+    default:     return -1;
+    }
+}
+
+bool ch8::Interface::PollEvents(u16& keys) noexcept {
+    SDL_Event event;
+
+    while (SDL_PollEvent(&event)) {
+        switch (event.type) {
+        case SDL_QUIT:
+            return false;
+
+        case SDL_KEYDOWN:
+        case SDL_KEYUP: {
+            if (event.key.keysym.sym == SDLK_ESCAPE) {
+                return false;
+            }
+
+            if (event.key.keysym.sym == SDLK_TAB) {
+                if (event.type == SDL_KEYDOWN && !event.key.repeat) {
+                    turbo = !turbo;
+                }
+                break;
+            }
+
+            i32 key = mapKey(event.key.keysym.sym);
+            if (key < 0) {
+                break;
+            }
+
+            if (event.type == SDL_KEYDOWN) {
+                keys |= 1u << key;
+            } else {
+                keys &= ~(1u << key);
+            }
+
+            // The event's timestamp is in SDL ticks (milliseconds): how long ago it came is all that's needed.
+            if (latency != nullptr && !event.key.repeat) {
+                if (event.type == SDL_KEYDOWN) {
+                    const auto ago = std::chrono::milliseconds(SDL_GetTicks() - event.key.timestamp);
+                    latency->Pressed(u32(key), Latency::clock::now() - ago);
+                } else {
+                    latency->Released(u32(key));
+                }
+            }
+            break;
+        }
+        }
+    }
+
+    return true;
 }
\ No newline at end of file
@@ -4,13 +4,32 @@
 #include <SDL2/SDL.h>
 #include <string>
 #include "defines.hpp"
+#include "scaler.hpp"
 
 // Contains all interactive parts of the project (graphics, sound & keyboard input).
 
 namespace ch8 {
+    class Latency;
+
     struct Interface {
         SDL_Window* window = nullptr;
         SDL_Renderer* renderer = nullptr;
+        SDL_Texture* texture = nullptr;
+        SDL_AudioDeviceID audio = 0;
+
+        bool turbo = false;                 // Toggled by Tab
+        Latency* latency = nullptr;         // Told about key presses & releases, while measuring (see latency.hpp)
+
+        Scaler scaler;
+        SDL_Rect viewport = {0, 0, 0, 0};   // Where the texture goes: centered, at an integer multiple of the screen's size
+
+        // Tiled view: every screen is a tile of one atlas, at its native size (the renderer does the scaling).
+        SDL_Texture* atlas = nullptr;
+        Scaler tiler;                       // At factor 1 & without phosphor, which would need a state per tile
+        u32 tiles = 0;                      // The atlas was laid out for this many screens,
+        u32 columns = 0;                    // in this many columns
+        u32 rows = 0;
+        SDL_Rect atlasViewport = {0, 0, 0, 0};
 
         Interface();
         ~Interface();
@@ -33,6 +52,25 @@ namespace ch8 {
             SDL_RenderClear(renderer);
             SDL_RenderPresent(renderer);
         }
+
+        // Presents the bit-packed, SCREEN_WIDTH x SCREEN_HEIGHT framebuffer.
+        void Draw(const u8* screen) noexcept;
+
+        // Presents count framebuffers side by side, in as many columns as makes them the largest.
+        // One texture upload & one present, no matter the count.
+        void DrawTiles(const u8* const* screens, u32 count) noexcept;
+
+        // Queues one frame's worth of beeping.
+        void Beep() noexcept;
+
+        // Updates the keypad (bit n is set while key n is held down) & turbo. Returns false, if the user wants to quit.
+        // Key presses are timestamped for the latency, if it's measured.
+        bool PollEvents(u16& keys) noexcept;
+
+        // Blocks until there's an event for PollEvents.
+        void WaitEvents() noexcept {
+            SDL_WaitEvent(nullptr);
+        }
     };
 }
 
@@ -0,0 +1,315 @@
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "chip8.hpp"
+#include "server.hpp"
+
+using namespace ch8::server;
+
+// What CREATE makes: a headless machine, addressed by its index in instances.
+struct ch8::server::Server::Instance: CacheAligned {
+    Chip8   state;
+    Program program;
+
+    Instance()
+        : program(state, nullptr, 0)
+    {}
+};
+
+struct ch8::server::Server::Client {
+    int fd;
+    std::vector<u8> input;
+    std::vector<u8> output;
+
+    explicit Client(int fd)
+        : fd(fd)
+    {}
+
+    ~Client() {
+        close(fd);
+    }
+};
+
+static volatile sig_atomic_t stopping = 0;
+
+static void onSignal(int) {
+    stopping = 1;
+}
+
+static void put(std::vector<u8>& out, u64 value, u32 bytes) {
+    for (u32 k = 0; k < bytes; ++k, value >>= 8) {
+        out.push_back(u8(value));
+    }
+}
+
+static u32 get(const u8* in, u32 bytes) noexcept {
+    u32 value = 0;
+
+    for (u32 k = bytes; k > 0; --k) {
+        value = value << 8 | in[k - 1];
+    }
+
+    return value;
+}
+
+static void setNonBlocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+
+// C-tors
+
+Server::Server(const std::string& path)
+    : path(path)
+    , listener(socket(AF_UNIX, SOCK_STREAM, 0))
+{
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+
+    if (listener < 0) {
+        throw std::runtime_error(std::string("socket: ") + strerror(errno));
+    }
+
+    if (path.size() >= sizeof(address.sun_path)) {
+        close(listener);
+        throw std::runtime_error(path + ": Socket path too long");
+    }
+
+    strcpy(address.sun_path, path.c_str());
+    unlink(path.c_str());
+
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 64) != 0) {
+        const std::string error = path + ": " + strerror(errno);
+        close(listener);
+        throw std::runtime_error(error);
+    }
+
+    setNonBlocking(listener);
+}
+
+Server::~Server() {
+    clients.clear();
+    close(listener);
+    unlink(path.c_str());
+}
+
+
+// Serving
+
+void Server::Run() {
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    std::vector<pollfd> polled;
+    u8 buffer[1u << 16];
+
+    while (!stopping) {
+        polled.assign(1, pollfd{listener, POLLIN, 0});
+
+        for (auto& client: clients) {
+            polled.push_back(pollfd{client->fd, short(POLLIN | (client->output.empty() ? 0 : POLLOUT)), 0});
+        }
+
+        if (poll(polled.data(), polled.size(), -1) < 0) {
+            continue;   // EINTR, most likely from a signal
+        }
+
+        // Clients from before the accept line up with polled[1...].
+        const std::size_t polledClients = clients.size();
+
+        if (polled[0].revents & POLLIN) {
+            for (int fd; (fd = accept(listener, nullptr, nullptr)) >= 0;) {
+                setNonBlocking(fd);
+                clients.push_back(std::make_unique<Client>(fd));
+            }
+        }
+
+        for (std::size_t c = 0; c < polledClients; ++c) {
+            Client& client = *clients[c];
+            bool closed = false;
+
+            if (polled[c + 1].revents & (POLLIN | POLLHUP | POLLERR)) {
+                for (;;) {
+                    const ssize_t count = recv(client.fd, buffer, sizeof(buffer), 0);
+
+                    if (count > 0) {
+                        client.input.insert(client.input.end(), buffer, buffer + count);
+                    } else {
+                        closed = count == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+                        break;
+                    }
+                }
+
+                // Every complete request is answered, in order.
+                std::size_t at = 0;
+
+                while (client.input.size() - at >= HEADER_LEN) {
+                    const u8* header = &client.input[at];
+                    const u32 length = get(header + 4, 4);
+
+                    if (length > MAX_PAYLOAD) {
+                        closed = true;
+                        break;
+                    }
+
+                    if (client.input.size() - at < HEADER_LEN + length) {
+                        break;
+                    }
+
+                    Handle(client, header[0], u16(get(header + 2, 2)), header + HEADER_LEN, length);
+                    at += HEADER_LEN + length;
+                }
+
+                client.input.erase(client.input.begin(), client.input.begin() + at);
+            }
+
+            while (!closed && !client.output.empty()) {
+                const ssize_t count = send(client.fd, client.output.data(), client.output.size(), MSG_NOSIGNAL);
+
+                if (count > 0) {
+                    client.output.erase(client.output.begin(), client.output.begin() + count);
+                } else {
+                    closed = errno != EAGAIN && errno != EWOULDBLOCK;
+                    break;
+                }
+            }
+
+            if (closed) {
+                clients[c].reset();
+            }
+        }
+
+        clients.erase(std::remove(clients.begin(), clients.end(), nullptr), clients.end());
+    }
+}
+
+void Server::Handle(Client& client, u8 command, u16 id, const u8* payload, u32 length) {
+    std::vector<u8>& out = client.output;
+    const std::size_t header = out.size();
+
+    // The header goes first, its status & length are filled in at the end.
+    out.resize(header + HEADER_LEN);
+    out[header + 1] = command;
+    out[header + 2] = u8(id);
+    out[header + 3] = u8(id >> 8);
+
+    auto finish = [&out, header](STATUS status) {
+        const u32 length = u32(out.size() - header - HEADER_LEN);
+
+        out[header] = status;
+        for (u32 k = 0; k < 4; ++k) {
+            out[header + 4 + k] = u8(length >> (k * 8));
+        }
+    };
+
+    if (command == COMMAND_PING) {
+        out.insert(out.end(), payload, payload + length);
+        return finish(STATUS_OK);
+    }
+
+    if (command == COMMAND_CREATE) {
+        std::size_t slot = std::find(instances.begin(), instances.end(), nullptr) - instances.begin();
+
+        if (slot > 0xffff) {
+            return finish(STATUS_NO_INSTANCE);
+        }
+
+        if (slot == instances.size()) {
+            instances.emplace_back();
+        }
+
+        instances[slot] = std::make_unique<Instance>();
+        out[header + 2] = u8(slot);
+        out[header + 3] = u8(slot >> 8);
+        put(out, slot, 2);
+        return finish(STATUS_OK);
+    }
+
+    if (command > COMMAND_POKE) {
+        return finish(STATUS_UNKNOWN_COMMAND);
+    }
+
+    if (id >= instances.size() || instances[id] == nullptr) {
+        return finish(STATUS_NO_INSTANCE);
+    }
+
+    Instance& instance = *instances[id];
+    Chip8& state = instance.state;
+
+    switch (command) {
+    case COMMAND_DESTROY:
+        instances[id].reset();
+        break;
+
+    case COMMAND_LOAD:
+        instance.program.Assign(payload, length);
+        instance.program.Load();
+        break;
+
+    case COMMAND_STEP:
+        if (length != 4 || get(payload, 4) > MAX_FRAMES) {
+            return finish(STATUS_BAD_PAYLOAD);
+        }
+
+        instance.program.RunFrames(get(payload, 4));
+
+        put(out, state.Hash(), 8);
+        break;
+
+    case COMMAND_KEYS:
+        if (length != 2) {
+            return finish(STATUS_BAD_PAYLOAD);
+        }
+
+        state.keys = u16(get(payload, 2));
+        break;
+
+    case COMMAND_REGS:
+        out.insert(out.end(), state.v.begin(), state.v.end());
+        put(out, state.i, 2);
+        put(out, state.sp, 2);
+        put(out, state.pc, 2);
+        put(out, state.dt, 1);
+        put(out, state.st, 1);
+
+        for (u16 address: state.stack) {
+            put(out, address, 2);
+        }
+        break;
+
+    case COMMAND_SCREEN:
+        out.insert(out.end(), state.memory.begin() + SCREEN_START, state.memory.end());
+        break;
+
+    case COMMAND_PEEK:
+        if (length != 4 || get(payload + 2, 2) > MEM_SIZE) {
+            return finish(STATUS_BAD_PAYLOAD);
+        }
+
+        for (u16 k = 0, address = u16(get(payload, 2)); k < get(payload + 2, 2); ++k) {
+            out.push_back(state.At(address + k));
+        }
+        break;
+
+    case COMMAND_POKE:
+        if (length < 2) {
+            return finish(STATUS_BAD_PAYLOAD);
+        }
+
+        for (u32 k = 2; k < length; ++k) {
+            state.Store(u16(get(payload, 2) + k - 2), payload[k]);
+        }
+
+        instance.program.Stored(u16(get(payload, 2)), u16(length - 2));
+        break;
+    }
+
+    finish(STATUS_OK);
+}
@@ -0,0 +1,83 @@
+#ifndef GOGA_TAMAS_CHIP_8_SERVER_HPP
+#define GOGA_TAMAS_CHIP_8_SERVER_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "defines.hpp"
+
+// Control server: drives headless instances over a UNIX domain socket (POSIX only).
+//
+// Every request & response starts with an 8 byte header, all little-endian:
+// request:  u8 command, u8 reserved, u16 instance, u32 payload length
+// response: u8 status,  u8 command,  u16 instance, u32 payload length
+// Requests may be pipelined: the server handles whatever has arrived in order, and answers in the same order.
+// So a client can send a whole batch (say, STEP & SCREEN for a hundred instances) & read the answers afterwards.
+//
+// Commands, with their payloads (request -> response):
+// PING     anything -> the same
+// CREATE   - -> u16 instance
+// DESTROY  - -> -
+// LOAD     ROM -> -                            (resets the instance, too)
+// STEP     u32 frames -> u64 hash              (see Chip8::Hash, at most MAX_FRAMES at a time)
+// KEYS     u16 keys -> -
+// REGS     - -> v[16], u16 i, u16 sp, u16 pc, u8 dt, u8 st, u16 stack[16]
+// SCREEN   - -> the bit-packed display
+// PEEK     u16 address, u16 length -> bytes
+// POKE     u16 address, bytes -> -
+
+namespace ch8 {
+    namespace server {
+        enum COMMAND: u8 {
+            COMMAND_PING,
+            COMMAND_CREATE,
+            COMMAND_DESTROY,
+            COMMAND_LOAD,
+            COMMAND_STEP,
+            COMMAND_KEYS,
+            COMMAND_REGS,
+            COMMAND_SCREEN,
+            COMMAND_PEEK,
+            COMMAND_POKE
+        };
+
+        enum STATUS: u8 {
+            STATUS_OK,
+            STATUS_UNKNOWN_COMMAND,
+            STATUS_NO_INSTANCE,
+            STATUS_BAD_PAYLOAD
+        };
+
+        constexpr u32 HEADER_LEN  = 8;
+        constexpr u32 MAX_PAYLOAD = 1u << 16;   // Larger requests close the connection
+        constexpr u32 MAX_FRAMES  = 60 * 60;    // A minute: every other client waits while an instance steps
+        constexpr u32 REGS_LEN    = 16 + 2 * 3 + 2 + 2 * STACK_SIZE;
+
+        class Server {
+        public:
+            // Throws if the socket can't be set up. A stale socket file at path is replaced.
+            explicit Server(const std::string& path);
+            ~Server();
+
+            Server(const Server&) = delete;
+            Server& operator=(const Server&) = delete;
+
+            // Serves until SIGINT or SIGTERM.
+            void Run();
+
+        private:
+            struct Instance;
+            struct Client;
+
+            void Handle(Client& client, u8 command, u16 id, const u8* payload, u32 length);
+
+            std::string path;
+            int listener;
+
+            std::vector<std::unique_ptr<Instance>> instances;   // Destroyed ones leave a nullptr
+            std::vector<std::unique_ptr<Client>> clients;
+        };
+    }
+}
+
+#endif // GOGA_TAMAS_CHIP_8_SERVER_HPP
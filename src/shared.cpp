@@ -0,0 +1,113 @@
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "instructions.hpp"
+#include "shared.hpp"
+
+using namespace ch8::shared;
+
+static std::string objectName(const std::string& name) {
+    return "/chip8-" + name;
+}
+
+static void* map(const std::string& name, int flags, int protection) {
+    const int fd = shm_open(objectName(name).c_str(), flags, 0644);
+
+    if (fd < 0) {
+        throw std::runtime_error(objectName(name) + ": " + strerror(errno));
+    }
+
+    if ((flags & O_CREAT) && ftruncate(fd, sizeof(Region)) != 0) {
+        close(fd);
+        throw std::runtime_error(objectName(name) + ": " + strerror(errno));
+    }
+
+    void* address = mmap(nullptr, sizeof(Region), protection, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (address == MAP_FAILED) {
+        throw std::runtime_error(objectName(name) + ": " + strerror(errno));
+    }
+
+    return address;
+}
+
+
+// Publisher
+
+Publisher::Publisher(const std::string& name)
+    : name(name)
+    , region(new (map(name, O_CREAT | O_RDWR, PROT_READ | PROT_WRITE)) Region())
+{
+    region->magic = MAGIC;
+    region->version = VERSION;
+}
+
+Publisher::~Publisher() {
+    munmap(region, sizeof(Region));
+    shm_unlink(objectName(name).c_str());
+}
+
+// The snapshot is put together on the side, so the sequence stays odd only for a memcpy.
+void Publisher::Publish(const Chip8& state) noexcept {
+    Snapshot snapshot;
+
+    snapshot.frame = ++frame;
+    memcpy(snapshot.v, state.v.data(), sizeof(snapshot.v));
+    snapshot.i = state.i;
+    snapshot.sp = state.sp;
+    snapshot.pc = state.pc;
+    snapshot.dt = state.dt;
+    snapshot.st = state.st;
+    memcpy(snapshot.stack, state.stack.data(), sizeof(snapshot.stack));
+    snapshot.keys = state.keys;
+    memcpy(snapshot.screen, &state.memory[SCREEN_START], sizeof(snapshot.screen));
+
+    const u32 sequence = region->sequence.load(std::memory_order_relaxed);
+
+    region->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    memcpy(&region->snapshot, &snapshot, sizeof(snapshot));
+
+    region->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+
+// Subscriber
+
+Subscriber::Subscriber(const std::string& name)
+    : region(static_cast<const Region*>(map(name, O_RDONLY, PROT_READ)))
+{
+    if (region->magic != MAGIC || region->version != VERSION) {
+        munmap(const_cast<Region*>(region), sizeof(Region));
+        throw std::runtime_error(objectName(name) + ": Not a published Chip-8");
+    }
+}
+
+Subscriber::~Subscriber() {
+    munmap(const_cast<Region*>(region), sizeof(Region));
+}
+
+bool Subscriber::Read(Snapshot& snapshot) const noexcept {
+    for (u32 attempt = 0; attempt < 1000; ++attempt) {
+        const u32 before = region->sequence.load(std::memory_order_acquire);
+
+        if (before % 2 != 0) {
+            continue;
+        }
+
+        memcpy(&snapshot, &region->snapshot, sizeof(snapshot));
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (region->sequence.load(std::memory_order_relaxed) == before) {
+            return true;
+        }
+    }
+
+    return false;
+}
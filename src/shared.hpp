@@ -0,0 +1,78 @@
+#ifndef GOGA_TAMAS_CHIP_8_SHARED_HPP
+#define GOGA_TAMAS_CHIP_8_SHARED_HPP
+
+#include <atomic>
+#include <string>
+#include "defines.hpp"
+
+// Publishing the machine into POSIX shared memory (/dev/shm/chip8-<name>), for other processes to watch.
+// The publisher rewrites the snapshot after every frame, under a seqlock: the sequence is odd while it's writing.
+// Readers copy the snapshot, then check that the sequence was even & didn't change, and retry if it did.
+// Neither side ever waits for the other. See tools/shared-reader.cpp.
+
+namespace ch8 {
+    struct Chip8;
+
+    namespace shared {
+        constexpr u32 MAGIC   = 0x53384843;     // "CH8S"
+        constexpr u32 VERSION = 1;
+
+        struct Snapshot {
+            u64 frame;                  // Frames published so far
+            u8  v[16];
+            u16 i;
+            u16 sp;
+            u16 pc;
+            u8  dt;
+            u8  st;
+            u16 stack[STACK_SIZE];
+            u16 keys;
+            u8  screen[SCREEN_WIDTH * SCREEN_HEIGHT / 8];  // Bit-packed, like in memory
+        };
+
+        struct Region {
+            u32              magic;
+            u32              version;
+            std::atomic<u32> sequence;
+            u32              reserved;
+            Snapshot         snapshot;
+        };
+
+        static_assert(ATOMIC_INT_LOCK_FREE == 2, "The sequence has to be lock-free to work across processes");
+
+        class Publisher {
+        public:
+            // Throws if the region can't be created.
+            explicit Publisher(const std::string& name);
+            ~Publisher();
+
+            Publisher(const Publisher&) = delete;
+            Publisher& operator=(const Publisher&) = delete;
+
+            void Publish(const Chip8& state) noexcept;
+
+        private:
+            std::string name;
+            Region*     region;
+            u64         frame = 0;
+        };
+
+        class Subscriber {
+        public:
+            // Throws if nothing is published under the name.
+            explicit Subscriber(const std::string& name);
+            ~Subscriber();
+
+            Subscriber(const Subscriber&) = delete;
+            Subscriber& operator=(const Subscriber&) = delete;
+
+            // Takes a consistent copy of the snapshot. Returns false if the publisher kept getting in the way.
+            bool Read(Snapshot& snapshot) const noexcept;
+
+        private:
+            const Region* region;
+        };
+    }
+}
+
+#endif // GOGA_TAMAS_CHIP_8_SHARED_HPP
@@ -0,0 +1,337 @@
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include <poll.h>
+#include <unistd.h>
+#include "terminal.hpp"
+
+static constexpr u32 ROW_BYTES = ch8::SCREEN_WIDTH / 8;
+static constexpr int ESCAPE_WAIT_MS = 50;  // How long the rest of a sequence may take after its Esc
+
+static u8 pixel(const u8* screen, u32 x, u32 y) noexcept {
+    return (screen[y * ROW_BYTES + x / 8] >> (7 - x % 8)) & 1;
+}
+
+// Blocks until everything is written (or the terminal is gone).
+static bool writeAll(const char* bytes, std::size_t length) noexcept {
+    while (length > 0) {
+        const ssize_t count = write(STDOUT_FILENO, bytes, length);
+
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+
+        if (count <= 0) {
+            return false;
+        }
+
+        bytes += count;
+        length -= std::size_t(count);
+    }
+
+    return true;
+}
+
+// Whether the terminal takes output without blocking: it doesn't, while a slow link is still catching up.
+static bool writable() noexcept {
+    pollfd out = {STDOUT_FILENO, POLLOUT, 0};
+    return poll(&out, 1, 0) == 1 && (out.revents & POLLOUT);
+}
+
+// The keypad, laid out like the window's.
+static i32 keyOf(char c) noexcept {
+    switch (std::tolower(static_cast<unsigned char>(c))) {
+    case 'x': return 0x0;
+    case '1': return 0x1;
+    case '2': return 0x2;
+    case '3': return 0x3;
+    case 'q': return 0x4;
+    case 'w': return 0x5;
+    case 'e': return 0x6;
+    case 'a': return 0x7;
+    case 's': return 0x8;
+    case 'd': return 0x9;
+    case 'z': return 0xa;
+    case 'c': return 0xb;
+    case '4': return 0xc;
+    case 'r': return 0xd;
+    case 'f': return 0xe;
+    case 'v': return 0xf;
+    default:  return -1;
+    }
+}
+
+
+// Renderer
+
+ch8::terminal::Renderer::Renderer(GLYPHS glyphs)
+    : glyphs(glyphs)
+    , columns(glyphs == GLYPHS_BRAILLE ? SCREEN_WIDTH / 2 : SCREEN_WIDTH)
+    , rows(glyphs == GLYPHS_BRAILLE ? SCREEN_HEIGHT / 4 : SCREEN_HEIGHT / 2)
+    , shown(columns * rows, 0)
+{
+    // Blank cells are spaces, everything else is 3 bytes of UTF-8: U+2580 & co. or U+2800 + the dots.
+    static const u8 HALF[4] = {0x00, 0x84, 0x80, 0x88};    // Bottom, top & both of U+2580
+
+    for (u32 code = 0; code < 256; ++code) {
+        Glyph& glyph = table[code];
+
+        if (code == 0) {
+            glyph = {{' ', 0, 0}, 1};
+        } else if (glyphs == GLYPHS_HALF) {
+            glyph = {{'\xe2', '\x96', char(HALF[code & 3])}, 3};
+        } else {
+            glyph = {{'\xe2', char(0xa0 | (code >> 6)), char(0x80 | (code & 0x3f))}, 3};
+        }
+    }
+
+    output.reserve(columns * rows * 16);
+}
+
+// Half blocks: the top pixel in bit 1, the bottom one in bit 0.
+// Braille: the dots' bits, 1-3 down the left column, 4-6 down the right one, then 7 & 8 at the bottom.
+u8 ch8::terminal::Renderer::Cell(const u8* screen, u32 column, u32 row) const noexcept {
+    if (glyphs == GLYPHS_HALF) {
+        return u8(pixel(screen, column, row * 2) << 1 | pixel(screen, column, row * 2 + 1));
+    }
+
+    const u32 x = column * 2, y = row * 4;
+    u8 cell = 0;
+
+    for (u32 dy = 0; dy < 3; ++dy) {
+        cell |= pixel(screen, x, y + dy) << dy;
+        cell |= pixel(screen, x + 1, y + dy) << (3 + dy);
+    }
+
+    cell |= pixel(screen, x, y + 3) << 6;
+    cell |= pixel(screen, x + 1, y + 3) << 7;
+    return cell;
+}
+
+// On the same row, skipping ahead rewrites the cells in between if that's shorter: they're unchanged, so shown is current.
+void ch8::terminal::Renderer::MoveTo(u32 column, u32 row) {
+    char move[24];
+
+    if (cursorKnown && cursorRow == row && cursorColumn <= column) {
+        if (cursorColumn == column) {
+            return;
+        }
+
+        const u32 length = u32(snprintf(move, sizeof(move), "\x1b[%uC", column - cursorColumn));
+        u32 gap = 0;
+
+        for (u32 k = cursorColumn; k < column; ++k) {
+            gap += table[shown[row * columns + k]].length;
+        }
+
+        if (gap > length) {
+            output.append(move, length);
+        } else {
+            for (u32 k = cursorColumn; k < column; ++k) {
+                const Glyph& glyph = table[shown[row * columns + k]];
+                output.append(glyph.bytes, glyph.length);
+            }
+        }
+    } else {
+        output.append(move, u32(snprintf(move, sizeof(move), "\x1b[%u;%uH", row + 1, column + 1)));
+    }
+
+    cursorColumn = column;
+    cursorRow = row;
+    cursorKnown = true;
+}
+
+const std::string& ch8::terminal::Renderer::Draw(const u8* screen) {
+    output.clear();
+
+    if (!cleared) {
+        output += "\x1b[H\x1b[2J";
+        std::fill(shown.begin(), shown.end(), 0);
+        cursorColumn = cursorRow = 0;
+        cursorKnown = cleared = true;
+    }
+
+    for (u32 row = 0; row < rows; ++row) {
+        for (u32 column = 0; column < columns; ++column) {
+            const u8 cell = Cell(screen, column, row);
+            u8& old = shown[row * columns + column];
+
+            if (cell == old) {
+                continue;
+            }
+
+            MoveTo(column, row);
+
+            const Glyph& glyph = table[cell];
+            output.append(glyph.bytes, glyph.length);
+            old = cell;
+            ++cursorColumn;     // Past the last column, the terminal may wrap: the next row is always moved to
+        }
+    }
+
+    return output;
+}
+
+void ch8::terminal::Renderer::Invalidate() noexcept {
+    cleared = false;
+}
+
+
+// Terminal
+
+ch8::terminal::Terminal::Terminal(Program& program, Chip8& state, GLYPHS glyphs)
+    : program(program)
+    , state(state)
+    , renderer(glyphs)
+{
+    if (tcgetattr(STDIN_FILENO, &saved) != 0) {
+        throw std::runtime_error(std::string("The terminal frontend needs a terminal on stdin: ") + strerror(errno));
+    }
+
+    // Raw: every byte as it comes, no echo, no signals (Ctrl-C is read like any key). Reads never block.
+    struct termios raw = saved;
+    raw.c_iflag &= ~tcflag_t(IXON | ICRNL | BRKINT | ISTRIP);
+    raw.c_lflag &= ~tcflag_t(ICANON | ECHO | ISIG | IEXTEN);
+    raw.c_cc[VMIN] = 0;
+    raw.c_cc[VTIME] = 0;
+
+    if (tcsetattr(STDIN_FILENO, TCSANOW, &raw) != 0) {
+        throw std::runtime_error(std::string("The terminal couldn't be put in raw mode: ") + strerror(errno));
+    }
+
+    // The alternate screen, without a cursor.
+    Send("\x1b[?1049h\x1b[?25l");
+}
+
+ch8::terminal::Terminal::~Terminal() {
+    Restore();
+}
+
+
+// Running
+
+void ch8::terminal::Terminal::Restore() noexcept {
+    if (!restored) {
+        Send("\x1b[0m\x1b[?25h\x1b[?1049l");
+        tcsetattr(STDIN_FILENO, TCSANOW, &saved);
+        restored = true;
+    }
+}
+
+bool ch8::terminal::Terminal::Send(const std::string& bytes) noexcept {
+    sent += bytes.size();
+    return writeAll(bytes.data(), bytes.size());
+}
+
+// Escape sequences (arrows & such) are skipped, up to their final byte, even if they arrive in pieces.
+// An Esc that nothing follows within ESCAPE_WAIT_MS is a lone Esc: it quits.
+bool ch8::terminal::Terminal::PollKeys() noexcept {
+    char input[64];
+    ssize_t count;
+
+    for (auto& left: held) {
+        left -= left > 0;
+    }
+
+    while ((count = read(STDIN_FILENO, input, sizeof(input))) > 0) {
+        for (ssize_t k = 0; k < count; ++k) {
+            const char c = input[k];
+
+            if (escape == ESCAPE_STARTED) {
+                escape = c == '[' || c == 'O' ? ESCAPE_SEQUENCE : ESCAPE_NONE;
+            } else if (escape == ESCAPE_SEQUENCE) {
+                escape = c >= 0x40 && c <= 0x7e ? ESCAPE_NONE : ESCAPE_SEQUENCE;
+            } else if (c == 0x03) {
+                return false;
+            } else if (c == 0x1b) {
+                escape = ESCAPE_STARTED;
+            } else if (c == 0x0c) {
+                renderer.Invalidate();
+            } else if (keyOf(c) >= 0) {
+                held[keyOf(c)] = HOLD_FRAMES;
+            }
+        }
+
+        pollfd in = {STDIN_FILENO, POLLIN, 0};
+        if (escape == ESCAPE_STARTED && poll(&in, 1, ESCAPE_WAIT_MS) == 0) {
+            return false;
+        }
+    }
+
+    state.keys = 0;
+    for (u32 key = 0; key < 16; ++key) {
+        state.keys |= u16(held[key] > 0) << key;
+    }
+
+    return true;
+}
+
+// Program::Execute's loop, minus turbo & phosphor. Frames are drawn only when the terminal can take them.
+void ch8::terminal::Terminal::Execute() {
+    using clock = std::chrono::steady_clock;
+    const auto refresh = std::chrono::microseconds(1000000 / FRAME_RATE);
+
+    program.Load();
+    state.seed = u32(clock::now().time_since_epoch().count()) | 1u;
+
+    const auto start = clock::now();
+    auto deadline = start;
+    bool beeping = false;
+
+    while (PollKeys()) {
+        deadline += refresh;
+
+        program.RunFrame();
+        ++frames;
+
+        pending = !writable();
+        if (pending) {
+            ++skipped;
+        } else {
+            Send(renderer.Draw(&state.memory[SCREEN_START]));
+        }
+
+        // One bell per beep, rather than one per frame.
+        if (state.st > 0 && !beeping) {
+            Send("\a");
+        }
+        beeping = state.st > 0;
+
+        auto now = clock::now();
+        if (now > deadline) {
+            deadline = now;
+        }
+
+        // Idle, silent & with no key held: nothing changes until a key is pressed.
+        // A skipped last frame is still drawn first, once the terminal takes it, so the screen isn't left stale.
+        if (program.Idle() && state.st == 0 && state.keys == 0) {
+            pollfd wait[2] = {{STDIN_FILENO, POLLIN, 0}, {STDOUT_FILENO, POLLOUT, 0}};
+
+            while (poll(wait, pending ? 2 : 1, -1) > 0 && wait[0].revents == 0) {
+                if (wait[1].revents & POLLOUT) {
+                    Send(renderer.Draw(&state.memory[SCREEN_START]));
+                }
+                pending = false;    // Drawn, or the terminal is gone
+            }
+
+            now = clock::now();
+            if (now > deadline) {
+                program.RunFrames(u32((now - deadline) / refresh));
+                deadline = now;
+            }
+        }
+
+        std::this_thread::sleep_until(deadline);
+    }
+
+    const std::chrono::duration<double> elapsed = clock::now() - start;
+    Restore();
+
+    fprintf(stderr, "%llu frames, %llu not drawn, %.0f bytes/s\n", (unsigned long long)frames,
+            (unsigned long long)skipped, sent / elapsed.count());
+}
@@ -0,0 +1,117 @@
+#ifndef GOGA_TAMAS_CHIP_8_TERMINAL_HPP
+#define GOGA_TAMAS_CHIP_8_TERMINAL_HPP
+
+#include <array>
+#include <string>
+#include <vector>
+#include <termios.h>
+#include "chip8.hpp"
+
+// Terminal frontend (POSIX only), for looking at a machine over SSH: no SDL, no display.
+//
+// The screen is drawn with Unicode block characters, in one of two ways:
+// half blocks: a cell is 1x2 pixels (64x16 cells); braille: a cell is 2x4 pixels (32x8 cells, half as wide on screen).
+// Only the cells that changed since the last frame are sent, with cursor moves in between (or the cells in between,
+// when they're shorter), as a single write. A frame the terminal isn't ready for is skipped, not queued:
+// the next one is diffed against what was last sent, so a slow link costs frames, never speed or lag.
+//
+// Keys are read from stdin in raw mode, with the same layout as the window (1234/qwer/asdf/zxcv).
+// Terminals only report presses, so a key is held down for HOLD_FRAMES after its last press (or repeat).
+// Esc or Ctrl-C quits, Ctrl-L redraws the whole screen.
+
+namespace ch8 {
+    namespace terminal {
+        enum GLYPHS: u32 {
+            GLYPHS_HALF,
+            GLYPHS_BRAILLE
+        };
+
+        constexpr u32 HOLD_FRAMES = 10;
+
+        // Turns frames into the escape sequences that bring the terminal from the last frame to this one.
+        // Keeps no terminal state but the cursor position, so it can be used without one (see bench/terminal.cpp).
+        class Renderer {
+        public:
+            explicit Renderer(GLYPHS glyphs);
+
+            // The output for the bit-packed display, valid until the next call. Empty if nothing changed.
+            const std::string& Draw(const u8* screen);
+
+            // Makes the next Draw clear the terminal & send every cell.
+            void Invalidate() noexcept;
+
+            u32 Columns() const noexcept {
+                return columns;
+            }
+
+            u32 Rows() const noexcept {
+                return rows;
+            }
+
+        private:
+            struct Glyph {
+                char bytes[3];
+                u8   length;
+            };
+
+            u8 Cell(const u8* screen, u32 column, u32 row) const noexcept;
+            void MoveTo(u32 column, u32 row);
+
+            const GLYPHS glyphs;
+            const u32    columns;
+            const u32    rows;
+
+            std::array<Glyph, 256> table;
+            std::vector<u8> shown;      // The cells on the terminal
+            std::string     output;
+
+            bool cleared = false;
+            u32  cursorColumn = 0;      // Where the cursor is, if known
+            u32  cursorRow    = 0;
+            bool cursorKnown  = false;
+        };
+
+        class Terminal {
+        public:
+            // Throws if stdin isn't a terminal.
+            Terminal(Program& program, Chip8& state, GLYPHS glyphs);
+
+            // Puts the terminal back the way it was.
+            ~Terminal();
+
+            Terminal(const Terminal&) = delete;
+            Terminal& operator=(const Terminal&) = delete;
+
+            // Like Program::Execute, until Esc or Ctrl-C. Reports the frames & the bytes sent per second to stderr afterwards.
+            void Execute();
+
+        private:
+            // Reads the keys pressed since the last frame. Returns false, if the user wants to quit.
+            bool PollKeys() noexcept;
+            bool Send(const std::string& bytes) noexcept;
+            void Restore() noexcept;
+
+            enum ESCAPE: u8 {
+                ESCAPE_NONE,
+                ESCAPE_STARTED,     // Esc read, the byte after it tells what it is
+                ESCAPE_SEQUENCE     // Inside a sequence, up to its final byte
+            };
+
+            Program& program;
+            Chip8&   state;
+            Renderer renderer;
+
+            struct termios saved;
+            std::array<u32, 16> held = {};  // Frames left for each key
+            bool restored = false;
+            ESCAPE escape = ESCAPE_NONE;    // Carried over, as a sequence may be split across reads
+            bool pending = false;           // The last frame wasn't drawn
+
+            u64 frames  = 0;        // Run, skipped ones weren't drawn
+            u64 skipped = 0;
+            u64 sent    = 0;
+        };
+    }
+}
+
+#endif // GOGA_TAMAS_CHIP_8_TERMINAL_HPP
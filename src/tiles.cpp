@@ -0,0 +1,80 @@
+#include <chrono>
+#include <thread>
+#include "sdl.hpp"
+#include "tiles.hpp"
+
+// C-tors
+
+ch8::Tiles::Tiles(Interface& interface, const os::Arguments& arguments, u32 count)
+    : interface(interface)
+    , arguments(arguments)
+    , count(count)
+    , scheduler(interface)
+{}
+
+
+// Running
+
+// The same loop as Program::Execute, the machines take turns on the scheduler & their frames are drawn together.
+void ch8::Tiles::Execute() {
+    using clock = std::chrono::steady_clock;
+    const auto refresh = std::chrono::microseconds(1000000 / FRAME_RATE);
+    const u32 seed = u32(clock::now().time_since_epoch().count());
+
+    for (u32 n = 0; n < count; ++n) {
+        const u32 slot = scheduler.Add(arguments.path.c_str(), arguments.options, seed + n * 0x9e3779b9u);
+        screens.push_back(&scheduler.State(slot).memory[SCREEN_START]);
+    }
+
+    interface.turbo = arguments.IsEnabled(OPTIONS_TURBO);
+
+    interface.Start("Chip-8", 1280, 960);
+    interface.ClearScreen();
+    os::Mark("Window cleared");
+
+    auto deadline = clock::now();
+    u16 keys = 0;
+
+    auto runFrame = [this, &keys]() {
+        for (u32 slot = 0; slot < count; ++slot) {
+            scheduler.State(slot).keys = keys;
+        }
+
+        scheduler.Tick();
+    };
+
+    while (interface.PollEvents(keys)) {
+        deadline += refresh;
+
+        if (!interface.turbo) {
+            runFrame();
+        } else if (arguments.speed != 0) {
+            for (u32 n = 0; n < arguments.speed; ++n) {
+                runFrame();
+            }
+        } else {
+            do {
+                runFrame();
+            } while (clock::now() < deadline);
+        }
+
+        interface.DrawTiles(screens.data(), u32(screens.size()));
+        os::MarkLast("First frame presented");
+
+        for (u32 slot = 0; slot < count; ++slot) {
+            if (scheduler.State(slot).st > 0) {
+                interface.Beep();
+                break;
+            }
+        }
+
+        auto now = clock::now();
+        if (now > deadline) {
+            deadline = now;
+        }
+
+        std::this_thread::sleep_until(deadline);
+    }
+
+    interface.Stop();
+}
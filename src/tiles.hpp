@@ -0,0 +1,30 @@
+#ifndef GOGA_TAMAS_CHIP_8_TILES_HPP
+#define GOGA_TAMAS_CHIP_8_TILES_HPP
+
+#include <vector>
+#include "scheduler.hpp"
+
+// Runs a batch of machines at once, shown as tiles of a single window (see Interface::DrawTiles).
+// Every machine runs the same ROM with its own random seed, and they all get the same keys.
+
+namespace ch8 {
+    class Tiles {
+    public:
+        // The ROM is loaded count times by Execute. Check that it loads with a Program first.
+        Tiles(Interface& interface, const os::Arguments& arguments, u32 count);
+
+        // Like Program::Execute, for every machine. Throws if the window can't be opened.
+        void Execute();
+
+    private:
+        Interface& interface;
+        const os::Arguments& arguments;
+
+        const u32 count;
+
+        Scheduler scheduler;
+        std::vector<const u8*> screens;
+    };
+}
+
+#endif // GOGA_TAMAS_CHIP_8_TILES_HPP
@@ -0,0 +1,523 @@
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include "trace.hpp"
+
+using namespace ch8::trace;
+
+static constexpr char MAGIC[8]   = {'C', 'H', '8', 'T', 'R', 'A', 'C', 'E'};
+static constexpr u32  VERSION    = 1;
+static constexpr u32  COMPRESSED = 0x1;
+
+static constexpr std::size_t BLOCK_SIZE = 4u << 20;
+static constexpr std::size_t MAX_RECORD = 8 + 3 * REGISTER_COUNT + 1 + 3 * (ch8::MEM_SIZE - ch8::SCREEN_START);
+static constexpr u32 SCREEN_BYTES = ch8::MEM_SIZE - ch8::SCREEN_START;
+
+static bool isWide(u8 id) noexcept {
+    return id == REGISTER_I || id == REGISTER_SP || id >= REGISTER_STACK;
+}
+
+static void put(std::vector<u8>& out, u64 value, u32 bytes) {
+    for (u32 k = 0; k < bytes; ++k, value >>= 8) {
+        out.push_back(u8(value));
+    }
+}
+
+static u64 get(const u8* in, u32 bytes) noexcept {
+    u64 value = 0;
+
+    for (u32 k = bytes; k > 0; --k) {
+        value = value << 8 | in[k - 1];
+    }
+
+    return value;
+}
+
+
+// Compression
+// LZ77, laid out like LZ4 blocks: a token with the literal length (high nibble) & match length - 4 (low nibble),
+// both continued by 255s if they're 15, the literals, then the match's u16 offset. The last sequence has no match.
+// Traces are very repetitive (the same loops, over & over), so this is enough to shrink them several times.
+
+static constexpr u32 MIN_MATCH = 4;
+static constexpr u32 HASH_BITS = 14;
+
+static void putLength(std::vector<u8>& out, std::size_t length) {
+    for (; length >= 255; length -= 255) {
+        out.push_back(255);
+    }
+
+    out.push_back(u8(length));
+}
+
+static void putSequence(std::vector<u8>& out, const u8* literals, std::size_t count, std::size_t offset, std::size_t length) {
+    const std::size_t extra = length != 0 ? length - MIN_MATCH : 0;
+    out.push_back(u8((count < 15 ? count : 15) << 4 | (extra < 15 ? extra : 15)));
+
+    if (count >= 15) {
+        putLength(out, count - 15);
+    }
+
+    out.insert(out.end(), literals, literals + count);
+
+    if (length != 0) {
+        put(out, offset, 2);
+
+        if (extra >= 15) {
+            putLength(out, extra - 15);
+        }
+    }
+}
+
+static void compressBlock(const u8* data, std::size_t size, std::vector<u8>& out) {
+    std::vector<u32> table(1u << HASH_BITS);    // Last position + 1 of each hashed sequence
+    out.clear();
+
+    std::size_t anchor = 0;
+
+    auto load = [data](std::size_t at) {
+        u32 value;
+        memcpy(&value, data + at, sizeof(value));
+        return value;
+    };
+
+    for (std::size_t at = 0; at + MIN_MATCH <= size;) {
+        const u32 sequence = load(at);
+        const u32 hash = u32(sequence * 2654435761u) >> (32 - HASH_BITS);
+        const std::size_t candidate = table[hash];
+        table[hash] = u32(at + 1);
+
+        if (candidate == 0 || at + 1 - candidate > 0xffff || load(candidate - 1) != sequence) {
+            ++at;
+            continue;
+        }
+
+        const std::size_t match = candidate - 1;
+        std::size_t length = MIN_MATCH;
+        while (at + length < size && data[match + length] == data[at + length]) {
+            ++length;
+        }
+
+        putSequence(out, data + anchor, at - anchor, at - match, length);
+        at += length;
+        anchor = at;
+    }
+
+    putSequence(out, data + anchor, size - anchor, 0, 0);
+}
+
+static void decompressBlock(const std::vector<u8>& in, std::vector<u8>& out) {
+    const u8* p = in.data();
+    const u8* end = p + in.size();
+    std::size_t at = 0;
+
+    auto length = [&p, end](std::size_t value) {
+        if (value == 15) {
+            u8 byte;
+            do {
+                if (p == end) {
+                    throw std::runtime_error("Corrupt trace block");
+                }
+                byte = *p++;
+                value += byte;
+            } while (byte == 255);
+        }
+        return value;
+    };
+
+    while (p < end) {
+        const u8 token = *p++;
+        const std::size_t count = length(token >> 4);
+
+        if (count > std::size_t(end - p) || count > out.size() - at) {
+            throw std::runtime_error("Corrupt trace block");
+        }
+
+        memcpy(&out[at], p, count);
+        p += count;
+        at += count;
+
+        if (p == end) {
+            break;
+        }
+
+        if (end - p < 2) {
+            throw std::runtime_error("Corrupt trace block");
+        }
+
+        const std::size_t offset = get(p, 2);
+        p += 2;
+        const std::size_t match = length(token & 0xf) + MIN_MATCH;
+
+        if (offset == 0 || offset > at || match > out.size() - at) {
+            throw std::runtime_error("Corrupt trace block");
+        }
+
+        // Matches may overlap what they're copying, so this goes byte by byte.
+        for (std::size_t k = 0; k < match; ++k, ++at) {
+            out[at] = out[at - offset];
+        }
+    }
+
+    if (at != out.size()) {
+        throw std::runtime_error("Corrupt trace block");
+    }
+}
+
+
+// Recorder
+
+Recorder::Recorder(const std::string& path, bool compress)
+    : file(fopen(path.c_str(), "wb"))
+    , compress(compress)
+{
+    if (file == nullptr) {
+        throw std::runtime_error(path + ": " + strerror(errno));
+    }
+
+    std::vector<u8> header(std::begin(MAGIC), std::end(MAGIC));
+    put(header, VERSION, 4);
+    put(header, compress ? COMPRESSED : 0, 4);
+    fwrite(header.data(), 1, header.size(), file);
+
+    block.resize(BLOCK_SIZE);
+}
+
+Recorder::~Recorder() {
+    Flush();
+    fclose(file);
+}
+
+// Only 00E0, Dxyn, Fx33 & Fx55 write to memory, so that's all that has to be looked at afterwards.
+// Fx33 & Fx55 store every byte they cover, so those are all recorded, even when a byte got the value it already had.
+// The screen is compared to a copy instead: Dxyn only stores where its sprite has bits set, and those always flip,
+// while 00E0 is left to its opcode, it only records the bytes that weren't clear already.
+void Recorder::Before(const Chip8& state) noexcept {
+    const u8 l = state.At(state.pc);
+    const u8 r = state.At(state.pc + 1);
+
+    const OPCODE decoded = Classify(l, r);
+
+    pc = state.pc;
+    opcode = u16(l << 8 | r);
+    screen = decoded == OP_CLS || decoded == OP_DRW;
+
+    if (screen) {
+        watchStart = SCREEN_START;
+        watchCount = SCREEN_BYTES;
+        memcpy(watched, &state.memory[SCREEN_START], SCREEN_BYTES);
+    } else if (decoded == OP_LD_B) {
+        watchStart = state.i;
+        watchCount = 3;
+    } else if (decoded == OP_LD_I_V) {
+        watchStart = state.i;
+        watchCount = (l & 0xf) + 1;
+    } else {
+        watchCount = 0;
+    }
+}
+
+void Recorder::Step(const Chip8& state) noexcept {
+    Emit(state, false);
+    ++step;
+}
+
+void Recorder::Frame(const Chip8& state) noexcept {
+    screen = false;
+    watchCount = 0;
+    Emit(state, true);
+    ++frame;
+}
+
+// Writes straight into the block, which always has room for one more record.
+void Recorder::Emit(const Chip8& state, bool isFrame) noexcept {
+    if (used + MAX_RECORD > BLOCK_SIZE) {
+        Flush();
+    }
+
+    if (used == 0) {
+        blockStep = step;
+        blockFrame = frame;
+    }
+
+    // Collect the changes first, their count goes into the tag. Whole register files are compared first,
+    // since most steps change one register at most.
+    u8  ids[REGISTER_COUNT];
+    u16 values[REGISTER_COUNT];
+    u8  count = 0;
+
+    auto check = [&](u8 id, u16 value) {
+        if (registers[id] != value) {
+            registers[id] = value;
+            ids[count] = id;
+            values[count++] = value;
+        }
+    };
+
+    if (!isFrame) {
+        if (v != state.v) {
+            for (u8 x = 0; x < 16; ++x) {
+                check(REGISTER_V + x, state.v[x]);
+            }
+
+            v = state.v;
+        }
+
+        check(REGISTER_I, state.i);
+        check(REGISTER_SP, state.sp);
+
+        if (stack != state.stack) {
+            for (u8 n = 0; n < STACK_SIZE; ++n) {
+                check(REGISTER_STACK + n, state.stack[n]);
+            }
+
+            stack = state.stack;
+        }
+    }
+
+    check(REGISTER_DT, state.dt);
+    check(REGISTER_ST, state.st);
+
+    u8* const start = &block[used];
+    u8* out = start;
+
+    auto put16 = [&out](u16 value) {
+        *out++ = u8(value);
+        *out++ = u8(value >> 8);
+    };
+
+    *out++ = u8((isFrame ? 0x80 : 0) | (count < 31 ? count : 31));
+
+    if (!isFrame) {
+        if (step == blockStep || pc != next) {
+            *start |= 0x40;
+            put16(pc);
+        }
+
+        *out++ = u8(opcode >> 8);
+        *out++ = u8(opcode);
+        next = pc + 2;
+    }
+
+    if (count >= 31) {
+        *out++ = count;
+    }
+
+    for (u8 k = 0; k < count; ++k) {
+        *out++ = ids[k];
+
+        if (isWide(ids[k])) {
+            put16(values[k]);
+        } else {
+            *out++ = u8(values[k]);
+        }
+    }
+
+    // The screen is compared 8 bytes at a time, a sprite only touches a few of them.
+    u8* const writes = out++;
+
+    if (screen) {
+        for (u16 k = 0; k < SCREEN_BYTES; k += 8) {
+            u64 before, after;
+            memcpy(&before, &watched[k], 8);
+            memcpy(&after, &state.memory[SCREEN_START + k], 8);
+
+            if (before == after) {
+                continue;
+            }
+
+            for (u16 n = k; n < k + 8; ++n) {
+                if (state.memory[SCREEN_START + n] != watched[n]) {
+                    put16(SCREEN_START + n);
+                    *out++ = state.memory[SCREEN_START + n];
+                }
+            }
+        }
+    } else {
+        for (u16 k = 0; k < watchCount; ++k) {
+            const u16 address = (watchStart + k) & (MEM_SIZE - 1);
+
+            put16(address);
+            *out++ = state.memory[address];
+        }
+    }
+
+    if (out == writes + 1) {
+        out = writes;
+    } else {
+        *start |= 0x20;
+        *writes = u8((out - writes - 1) / 3 - 1);
+    }
+
+    used += out - start;
+}
+
+void Recorder::Flush() noexcept {
+    if (used == 0) {
+        return;
+    }
+
+    const u8* data = block.data();
+    std::size_t size = used;
+
+    if (compress) {
+        compressBlock(block.data(), used, packed);
+
+        if (packed.size() < used) {
+            data = packed.data();
+            size = packed.size();
+        }
+    }
+
+    std::vector<u8> header;
+    put(header, used, 4);
+    put(header, size, 4);
+    put(header, blockStep, 8);
+    put(header, blockFrame, 8);
+
+    fwrite(header.data(), 1, header.size(), file);
+    fwrite(data, 1, size, file);
+    used = 0;
+}
+
+
+// Reader
+
+Reader::Reader(const std::string& path)
+    : file(fopen(path.c_str(), "rb"))
+{
+    if (file == nullptr) {
+        throw std::runtime_error(path + ": " + strerror(errno));
+    }
+
+    u8 header[24];
+
+    if (fread(header, 1, 16, file) != 16 || memcmp(header, MAGIC, sizeof(MAGIC)) != 0 || get(header + 8, 4) != VERSION) {
+        fclose(file);
+        throw std::runtime_error(path + ": Not a trace");
+    }
+
+    while (fread(header, 1, sizeof(header), file) == sizeof(header)) {
+        BlockHeader block;
+        block.raw    = u32(get(header, 4));
+        block.stored = u32(get(header + 4, 4));
+        block.step   = get(header + 8, 8);
+        block.frame  = get(header + 16, 8);
+        block.offset = ftell(file);
+
+        blocks.push_back(block);
+        fseek(file, block.stored, SEEK_CUR);
+    }
+}
+
+Reader::~Reader() {
+    fclose(file);
+}
+
+void Reader::Load(std::size_t index) {
+    const BlockHeader& block = blocks.at(index);
+
+    if (block.raw > BLOCK_SIZE || block.stored > block.raw) {
+        throw std::runtime_error("Corrupt trace block");
+    }
+
+    raw.resize(block.raw);
+
+    std::vector<u8>& target = block.stored < block.raw ? packed : raw;
+    target.resize(block.stored);
+
+    fseek(file, block.offset, SEEK_SET);
+    if (fread(target.data(), 1, target.size(), file) != target.size()) {
+        throw std::runtime_error("Truncated trace");
+    }
+
+    if (block.stored < block.raw) {
+        decompressBlock(packed, raw);
+    }
+
+    position = 0;
+    step = block.step;
+    frame = block.frame;
+}
+
+// The block is only trusted as far as it goes: every record has to fit in what's left of it,
+// and name registers & addresses that exist.
+bool Reader::Next(Record& record) {
+    const u8* p = raw.data() + position;
+    const u8* end = raw.data() + raw.size();
+
+    if (p >= end) {
+        return false;
+    }
+
+    auto take = [&p, end](std::size_t bytes) {
+        if (std::size_t(end - p) < bytes) {
+            throw std::runtime_error("Corrupt trace block");
+        }
+
+        const u8* at = p;
+        p += bytes;
+        return at;
+    };
+
+    const u8 tag = *take(1);
+    record.frame = tag & 0x80;
+
+    if (record.frame) {
+        record.pc = next;
+        record.opcode = 0;
+        record.step = step;
+        record.frameIndex = frame++;
+    } else {
+        if (tag & 0x40) {
+            next = u16(get(take(2), 2));
+        }
+
+        const u8* opcode = take(2);
+        record.pc = next;
+        record.opcode = u16(opcode[0] << 8 | opcode[1]);
+        next = record.pc + 2;
+
+        record.step = step++;
+        record.frameIndex = frame;
+    }
+
+    record.registers = tag & 0x1f;
+    if (record.registers == 31) {
+        record.registers = *take(1);
+    }
+
+    if (record.registers > REGISTER_COUNT) {
+        throw std::runtime_error("Corrupt trace block");
+    }
+
+    for (u8 k = 0; k < record.registers; ++k) {
+        const u8 id = *take(1);
+
+        if (id >= REGISTER_COUNT || (id > REGISTER_ST && id < REGISTER_STACK)) {
+            throw std::runtime_error("Corrupt trace block");
+        }
+
+        record.ids[k] = id;
+        record.values[k] = u16(get(take(isWide(id) ? 2 : 1), isWide(id) ? 2 : 1));
+    }
+
+    record.writes = 0;
+
+    if (tag & 0x20) {
+        record.writes = *take(1) + 1;
+
+        for (u16 k = 0; k < record.writes; ++k) {
+            const u8* write = take(3);
+            record.addresses[k] = u16(get(write, 2));
+            record.bytes[k] = write[2];
+
+            if (record.addresses[k] >= MEM_SIZE) {
+                throw std::runtime_error("Corrupt trace block");
+            }
+        }
+    }
+
+    position = p - raw.data();
+    return true;
+}
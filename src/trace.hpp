@@ -0,0 +1,141 @@
+#ifndef GOGA_TAMAS_CHIP_8_TRACE_HPP
+#define GOGA_TAMAS_CHIP_8_TRACE_HPP
+
+#include <array>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "instructions.hpp"
+
+// Execution traces: what every step (and every timer tick) changed, for digging into long runs after the fact.
+// See tools/trace.cpp for the query tool.
+//
+// File layout, all little-endian:
+// "CH8TRACE", u32 version (1), u32 flags (1: compressed)
+// Then blocks of whole records, each with a 24 byte header:
+// u32 raw length, u32 stored length (smaller than the raw length if the block is compressed),
+// u64 index of the first step, u64 index of the first frame.
+//
+// A record starts with a tag byte:
+// bit 7:    timer tick (a frame) rather than a step
+// bit 6:    a u16 pc follows (otherwise it's the previous step's pc + 2, blocks always start with one)
+// bit 5:    memory writes follow the registers
+// bits 0-4: number of changed registers (31: the number follows in a u8)
+// Steps then have their opcode (u16, big-endian, like in memory). Each register is a u8 id & its new value,
+// one byte for V0-VF, DT & ST, two for the rest. Writes are a u8 count - 1, then u16 address & u8 value pairs:
+// every byte Fx33 & Fx55 stored, changed or not, and every screen byte that 00E0 or Dxyn changed.
+
+namespace ch8 {
+    namespace trace {
+        enum REGISTER: u8 {
+            REGISTER_V     = 0,     // V0-VF are 0-15
+            REGISTER_I     = 16,
+            REGISTER_SP    = 17,
+            REGISTER_DT    = 18,
+            REGISTER_ST    = 19,
+            REGISTER_STACK = 32,    // stack[n] is 32 + n
+            REGISTER_COUNT = REGISTER_STACK + STACK_SIZE
+        };
+
+        struct Record {
+            bool frame;
+            u64  step;      // Of a step, its index. Of a frame, the amount of steps before it.
+            u64  frameIndex;
+            u16  pc;
+            u16  opcode;
+
+            u8  registers;
+            u8  ids[REGISTER_COUNT];
+            u16 values[REGISTER_COUNT];
+
+            u16 writes;
+            u16 addresses[SCREEN_WIDTH * SCREEN_HEIGHT / 8];
+            u8  bytes[SCREEN_WIDTH * SCREEN_HEIGHT / 8];
+        };
+
+        struct BlockHeader {
+            u32 raw;
+            u32 stored;
+            u64 step;
+            u64 frame;
+            long offset;    // Of the block's data in the file, not stored
+        };
+
+        // Writes records into a large block, compressing it (optionally) when it's full.
+        class Recorder {
+        public:
+            // Throws if the file can't be created.
+            Recorder(const std::string& path, bool compress);
+            ~Recorder();
+
+            Recorder(const Recorder&) = delete;
+            Recorder& operator=(const Recorder&) = delete;
+
+            // Call Before, then execute the instruction at pc, then call Step.
+            void Before(const Chip8& state) noexcept;
+            void Step(const Chip8& state) noexcept;
+
+            // Call after ticking the timers.
+            void Frame(const Chip8& state) noexcept;
+
+        private:
+            void Emit(const Chip8& state, bool frame) noexcept;
+            void Flush() noexcept;
+
+            FILE* file;
+            bool  compress;
+
+            std::vector<u8> block;
+            std::vector<u8> packed;
+            std::size_t used       = 0;     // Bytes of the block taken by records
+            u64         step       = 0;
+            u64         frame      = 0;
+            u64         blockStep  = 0;
+            u64         blockFrame = 0;
+            u16         next       = 0;     // The pc that doesn't have to be written down
+
+            // The registers as of the last record, and the memory that the current instruction may write.
+            std::array<u16, REGISTER_COUNT> registers = {};
+            std::array<u8, 16>              v         = {};
+            std::array<u16, STACK_SIZE>     stack     = {};
+            u16 pc         = 0;
+            u16 opcode     = 0;
+            u16 watchStart = 0;
+            u16 watchCount = 0;
+            bool screen    = false;     // Whether the writes are found by comparing the screen to watched
+            u8  watched[SCREEN_WIDTH * SCREEN_HEIGHT / 8];
+        };
+
+        class Reader {
+        public:
+            // Throws if the file isn't a trace.
+            explicit Reader(const std::string& path);
+            ~Reader();
+
+            Reader(const Reader&) = delete;
+            Reader& operator=(const Reader&) = delete;
+
+            const std::vector<BlockHeader>& Blocks() const noexcept {
+                return blocks;
+            }
+
+            // Reads & decompresses a block, then Next walks its records.
+            // Both throw if the block is corrupt.
+            void Load(std::size_t index);
+            bool Next(Record& record);
+
+        private:
+            FILE* file;
+            std::vector<BlockHeader> blocks;
+
+            std::vector<u8> raw;
+            std::vector<u8> packed;
+            std::size_t position = 0;
+            u16 next   = 0;
+            u64 step   = 0;
+            u64 frame  = 0;
+        };
+    }
+}
+
+#endif // GOGA_TAMAS_CHIP_8_TRACE_HPP
@@ -0,0 +1,507 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "../src/flow.hpp"
+
+// Static statistics over a corpus of ROMs, to decide which opcodes & idioms are worth optimizing.
+// Usage: chip8-corpus [directory | rom]...   (roms/ by default; directories are searched for *.ch8, recursively)
+//
+// The ROMs are read & analysed on every core. Only reachable code counts (see flow.hpp, Bnnn targets aren't followed),
+// so data that happens to look like instructions doesn't skew the numbers.
+// Prints one CSV to stdout, "section,item,count,roms": count is instructions (ROMs for calldepth), roms how many use it.
+//
+// opcode       every instruction, by pattern & mnemonic
+// sequence2-4  runs of 2-4 instructions that always execute in a row: no jump lands inside them, and only the last
+//              may transfer control or skip. By mnemonic, the TOP most common of each length
+// sprite       Dxyn by height (n)
+// calldepth    the deepest nesting of CALLs, per ROM; "recursive" if a subroutine can call itself, 17+ overflows the stack
+// quirk        instructions whose meaning differs between interpreters: 8xy6/8xyE (shift Vx or Vy, which only matters
+//              if x != y), Fx55/Fx65 (I incremented or not) & Bnnn (V0 or Vx, which only matters if x != 0)
+// summary      ROMs read & failed, their bytes, & their words that are code
+
+using namespace ch8;
+
+constexpr u32 TOP = 100;
+constexpr u32 DEPTHS = STACK_SIZE + 2;  // 0-16 fit on the stack, the last counts the rest
+
+enum QUIRK: u32 {
+    QUIRK_SHIFT,
+    QUIRK_SHIFT_XY,
+    QUIRK_LOAD_STORE,
+    QUIRK_JUMP,
+    QUIRK_JUMP_X,
+    QUIRK_COUNT
+};
+
+static const char* QUIRK_NAMES[QUIRK_COUNT] = {
+    "8xy6/8xye shift", "8xy6/8xye shift x!=y", "fx55/fx65 load/store", "bnnn jump", "bnnn jump x!=0"
+};
+
+struct Counter {
+    u64 count = 0;
+    u64 roms  = 0;
+};
+
+struct Stats {
+    u64 roms = 0, failed = 0, bytes = 0, words = 0, code = 0;
+
+    std::array<Counter, OP_COUNT>    opcodes;
+    std::array<Counter, 16>          sprites;
+    std::array<Counter, QUIRK_COUNT> quirks;
+    std::array<u64, DEPTHS>          depths = {};
+    u64                              recursive = 0;
+
+    // By length - 2: the mnemonics' OPCODEs, a byte each, the first one lowest.
+    std::array<std::unordered_map<u32, Counter>, 3> sequences;
+
+    void Merge(const Stats& other) {
+        roms += other.roms;
+        failed += other.failed;
+        bytes += other.bytes;
+        words += other.words;
+        code += other.code;
+        recursive += other.recursive;
+
+        auto add = [](Counter& to, const Counter& from) {
+            to.count += from.count;
+            to.roms += from.roms;
+        };
+
+        for (u32 k = 0; k < OP_COUNT; ++k) add(opcodes[k], other.opcodes[k]);
+        for (u32 k = 0; k < 16; ++k) add(sprites[k], other.sprites[k]);
+        for (u32 k = 0; k < QUIRK_COUNT; ++k) add(quirks[k], other.quirks[k]);
+        for (u32 k = 0; k < DEPTHS; ++k) depths[k] += other.depths[k];
+
+        for (u32 n = 0; n < sequences.size(); ++n) {
+            for (const auto& entry: other.sequences[n]) {
+                add(sequences[n][entry.first], entry.second);
+            }
+        }
+    }
+};
+
+// Files
+
+static bool isRom(const std::string& path) {
+    return path.size() > 4 && path.compare(path.size() - 4, 4, ".ch8") == 0;
+}
+
+// Symbolic links to directories aren't followed, so there are no loops.
+static void collect(const std::string& path, std::vector<std::string>& paths) {
+    struct stat info;
+
+    if (lstat(path.c_str(), &info) != 0) {
+        fprintf(stderr, "%s: %s\n", path.c_str(), strerror(errno));
+        return;
+    }
+
+    if (!S_ISDIR(info.st_mode)) {
+        paths.push_back(path);
+        return;
+    }
+
+    DIR* directory = opendir(path.c_str());
+    if (directory == nullptr) {
+        fprintf(stderr, "%s: %s\n", path.c_str(), strerror(errno));
+        return;
+    }
+
+    while (const dirent* entry = readdir(directory)) {
+        const std::string name = entry->d_name;
+        const std::string child = path + "/" + name;
+
+        if (name == "." || name == "..") {
+            continue;
+        }
+
+        if (lstat(child.c_str(), &info) == 0 && S_ISDIR(info.st_mode)) {
+            collect(child, paths);
+        } else if (isRom(name)) {
+            paths.push_back(child);
+        }
+    }
+
+    closedir(directory);
+}
+
+// The whole file, padded to whole words. Unlike os::LoadChip8File, there's no size limit: a ROM too large to load still counts.
+static bool load(const std::string& path, std::vector<u8>& bytes) {
+    FILE* file = fopen(path.c_str(), "rb");
+
+    if (file == nullptr) {
+        fprintf(stderr, "%s: %s\n", path.c_str(), strerror(errno));
+        return false;
+    }
+
+    u8 chunk[4096];
+    std::size_t count;
+
+    bytes.clear();
+    while ((count = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        bytes.insert(bytes.end(), chunk, chunk + count);
+    }
+
+    const bool failed = ferror(file) != 0;
+    fclose(file);
+
+    if (failed) {
+        fprintf(stderr, "%s: read failed\n", path.c_str());
+        return false;
+    }
+
+    if (bytes.size() % 2 != 0) {
+        bytes.push_back(0);
+    }
+
+    return true;
+}
+
+// Analysis
+
+// Whether the next word isn't always the next one executed: jumps, RET & skips.
+static bool transfers(OPCODE opcode) noexcept {
+    switch (opcode) {
+    case OP_JP:
+    case OP_RET:
+    case OP_JP_V0:
+    case OP_SE:
+    case OP_SNE:
+    case OP_SE_V:
+    case OP_SNE_V:
+    case OP_SKP:
+    case OP_SKNP:
+        return true;
+    default:
+        return false;
+    }
+}
+
+class Rom {
+public:
+    explicit Rom(const std::vector<u8>& bytes)
+        : bytes(bytes)
+        , flow(bytes)
+        , words(u32(bytes.size() / 2))
+    {}
+
+    void Count(Stats& stats) const {
+        std::array<bool, OP_COUNT> used = {};
+        std::array<bool, 16> sprites = {};
+        std::array<bool, QUIRK_COUNT> quirks = {};
+
+        stats.roms += 1;
+        stats.bytes += bytes.size();
+        stats.words += words;
+
+        for (u32 word = 0; word < words; ++word) {
+            if (!Code(word)) {
+                continue;
+            }
+
+            const OPCODE opcode = Opcode(word);
+            const u8 l = bytes[word * 2], r = bytes[word * 2 + 1];
+            const bool xy = (l & 0xf) != (r >> 4);
+
+            stats.code += 1;
+            stats.opcodes[opcode].count += 1;
+            used[opcode] = true;
+
+            auto quirk = [&](QUIRK q) {
+                stats.quirks[q].count += 1;
+                quirks[q] = true;
+            };
+
+            switch (opcode) {
+            case OP_DRW:
+                stats.sprites[r & 0xf].count += 1;
+                sprites[r & 0xf] = true;
+                break;
+            case OP_SHR:
+            case OP_SHL:
+                quirk(QUIRK_SHIFT);
+                if (xy) quirk(QUIRK_SHIFT_XY);
+                break;
+            case OP_LD_I_V:
+            case OP_LD_V_I:
+                quirk(QUIRK_LOAD_STORE);
+                break;
+            case OP_JP_V0:
+                quirk(QUIRK_JUMP);
+                if ((l & 0xf) != 0) quirk(QUIRK_JUMP_X);
+                break;
+            default:
+                break;
+            }
+        }
+
+        for (u32 k = 0; k < OP_COUNT; ++k) stats.opcodes[k].roms += used[k];
+        for (u32 k = 0; k < 16; ++k) stats.sprites[k].roms += sprites[k];
+        for (u32 k = 0; k < QUIRK_COUNT; ++k) stats.quirks[k].roms += quirks[k];
+
+        CountSequences(stats);
+
+        const i32 depth = Depth();
+        if (depth < 0) {
+            stats.recursive += 1;
+        } else {
+            stats.depths[std::min<u32>(u32(depth), DEPTHS - 1)] += 1;
+        }
+    }
+
+private:
+    bool Code(u32 word) const noexcept {
+        return flow.flags[word] & flow::FLAG_CODE;
+    }
+
+    OPCODE Opcode(u32 word) const noexcept {
+        return OPCODE(flow.opcodes[word]);
+    }
+
+    u16 Target(u32 word) const noexcept {
+        return u16((bytes[word * 2] & 0xf) << 8 | bytes[word * 2 + 1]);
+    }
+
+    // The word an address lands on, or words if it's outside the ROM (or odd).
+    u32 Word(u16 address) const noexcept {
+        if (address % 2 != 0 || address < MEM_START || u32(address - MEM_START) / 2 >= words) {
+            return words;
+        }
+
+        return (address - MEM_START) / 2u;
+    }
+
+    void CountSequences(Stats& stats) const {
+        std::array<std::unordered_set<u32>, 3> seen;
+
+        for (u32 first = 0; first < words; ++first) {
+            u32 key = 0;
+
+            for (u32 n = 0; n < 4 && first + n < words; ++n) {
+                const u32 word = first + n;
+
+                if (!Code(word) || (n > 0 && (flow.flags[word] & flow::FLAG_LEADER))) {
+                    break;
+                }
+
+                key |= u32(Opcode(word)) << (8 * n);
+
+                if (n > 0) {
+                    stats.sequences[n - 1][key].count += 1;
+
+                    if (seen[n - 1].insert(key).second) {
+                        stats.sequences[n - 1][key].roms += 1;
+                    }
+                }
+
+                if (transfers(Opcode(word))) {
+                    break;
+                }
+            }
+        }
+    }
+
+    // The CALLs a subroutine (or the entry point) makes, following its control flow up to its RETs.
+    std::vector<u32> Callees(u32 entry) const {
+        std::vector<u32> callees, work = {entry};
+        std::vector<bool> visited(words, false);
+
+        while (!work.empty()) {
+            u32 word = work.back();
+            work.pop_back();
+
+            for (; word < words && !visited[word]; ++word) {
+                visited[word] = true;
+
+                switch (Opcode(word)) {
+                case OP_CALL:
+                    if (Word(Target(word)) < words) callees.push_back(Word(Target(word)));
+                    continue;
+                case OP_SE:
+                case OP_SNE:
+                case OP_SE_V:
+                case OP_SNE_V:
+                case OP_SKP:
+                case OP_SKNP:
+                    work.push_back(word + 2);
+                    continue;
+                case OP_JP:
+                    work.push_back(Word(Target(word)));
+                    break;
+                case OP_RET:
+                case OP_JP_V0:
+                    break;
+                default:
+                    continue;
+                }
+
+                break;
+            }
+        }
+
+        return callees;
+    }
+
+    // Longest chain of nested CALLs from the entry point, -1 if a subroutine can end up calling itself.
+    // Depth first, with a stack of its own: chains of CALLs can be as long as the ROM.
+    i32 Depth() const {
+        struct Frame {
+            u32              entry;
+            std::vector<u32> callees;
+            std::size_t      next;
+        };
+
+        std::unordered_map<u32, i32> depths;     // -1 while being explored
+        std::vector<Frame> stack;
+
+        auto enter = [&](u32 entry) {
+            depths[entry] = -1;
+            stack.push_back({entry, Callees(entry), 0});
+        };
+
+        enter(0);
+
+        while (!stack.empty()) {
+            Frame& top = stack.back();
+
+            if (top.next == top.callees.size()) {
+                i32 depth = 0;
+
+                for (u32 callee: top.callees) {
+                    depth = std::max(depth, depths[callee] + 1);
+                }
+
+                depths[top.entry] = depth;
+                stack.pop_back();
+                continue;
+            }
+
+            const u32 callee = top.callees[top.next++];
+            const auto found = depths.find(callee);
+
+            if (found == depths.end()) {
+                enter(callee);
+            } else if (found->second < 0) {
+                return -1;
+            }
+        }
+
+        return depths[0];
+    }
+
+    const std::vector<u8>& bytes;
+    const flow::Analysis flow;
+    const u32 words;
+};
+
+// Output
+
+static void row(const char* section, const std::string& item, u64 count, u64 roms) {
+    printf("%s,\"%s\",%llu,%llu\n", section, item.c_str(), (unsigned long long)count, (unsigned long long)roms);
+}
+
+static void print(const Stats& stats) {
+    printf("section,item,count,roms\n");
+
+    for (u32 k = 0; k < OP_COUNT; ++k) {
+        const Pattern& pattern = PATTERNS[k];
+        row("opcode", std::string(k == OP_NOP ? "0nnn" : pattern.pattern) + " " + pattern.mnemonic,
+            stats.opcodes[k].count, stats.opcodes[k].roms);
+    }
+
+    for (u32 n = 0; n < stats.sequences.size(); ++n) {
+        std::vector<std::pair<u32, Counter>> sorted(stats.sequences[n].begin(), stats.sequences[n].end());
+
+        std::sort(sorted.begin(), sorted.end(), [](const std::pair<u32, Counter>& a, const std::pair<u32, Counter>& b) {
+            return a.second.count != b.second.count ? a.second.count > b.second.count : a.first < b.first;
+        });
+
+        const std::string section = "sequence" + std::to_string(n + 2);
+
+        for (u32 k = 0; k < sorted.size() && k < TOP; ++k) {
+            std::string item;
+
+            for (u32 op = 0; op < n + 2; ++op) {
+                item += (op > 0 ? " " : "") + std::string(PATTERNS[(sorted[k].first >> (8 * op)) & 0xff].mnemonic);
+            }
+
+            row(section.c_str(), item, sorted[k].second.count, sorted[k].second.roms);
+        }
+    }
+
+    for (u32 n = 0; n < 16; ++n) {
+        row("sprite", std::to_string(n), stats.sprites[n].count, stats.sprites[n].roms);
+    }
+
+    for (u32 depth = 0; depth < DEPTHS; ++depth) {
+        row("calldepth", std::to_string(depth) + (depth + 1 == DEPTHS ? "+" : ""), stats.depths[depth], stats.depths[depth]);
+    }
+    row("calldepth", "recursive", stats.recursive, stats.recursive);
+
+    for (u32 q = 0; q < QUIRK_COUNT; ++q) {
+        row("quirk", QUIRK_NAMES[q], stats.quirks[q].count, stats.quirks[q].roms);
+    }
+
+    row("summary", "roms", stats.roms, stats.roms);
+    row("summary", "failed", stats.failed, 0);
+    row("summary", "bytes", stats.bytes, stats.roms);
+    row("summary", "words", stats.words, stats.roms);
+    row("summary", "code words", stats.code, stats.roms);
+}
+
+int main(int argc, char** argv) {
+    using clock_type = std::chrono::steady_clock;
+
+    const auto start = clock_type::now();
+    std::vector<std::string> paths;
+
+    if (argc < 2) {
+        collect("roms", paths);
+    }
+    for (int k = 1; k < argc; ++k) {
+        collect(argv[k], paths);
+    }
+
+    // Every thread takes the next ROM until there are none left, counting into its own Stats.
+    const u32 threads = std::max(1u, std::min(std::thread::hardware_concurrency(), u32(paths.size())));
+    std::vector<Stats> partial(threads);
+    std::vector<std::thread> workers;
+    std::atomic<std::size_t> next(0);
+
+    for (u32 t = 0; t < threads; ++t) {
+        workers.emplace_back([&paths, &partial, &next, t]() {
+            std::vector<u8> bytes;
+
+            for (std::size_t k; (k = next++) < paths.size();) {
+                if (!load(paths[k], bytes)) {
+                    partial[t].failed += 1;
+                    continue;
+                }
+
+                Rom(bytes).Count(partial[t]);
+            }
+        });
+    }
+
+    Stats total;
+
+    for (u32 t = 0; t < threads; ++t) {
+        workers[t].join();
+        total.Merge(partial[t]);
+    }
+
+    print(total);
+
+    std::chrono::duration<double, std::milli> elapsed = clock_type::now() - start;
+    fprintf(stderr, "%llu ROMs in %.1f ms on %u threads\n", (unsigned long long)total.roms, elapsed.count(), threads);
+}
@@ -0,0 +1,66 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "../src/libchip8.h"
+
+/* Runs a ROM on a batch of machines, each holding a different key down, through the library, & prints their screens' hashes.
+ * Usage: chip8-lib-example <rom> */
+
+#define MACHINES 16
+#define FRAMES   600
+
+static unsigned long long fnv(const uint8_t* bytes, size_t length) {
+    unsigned long long hash = 0xcbf29ce484222325ull;
+
+    for (size_t k = 0; k < length; ++k) {
+        hash = (hash ^ bytes[k]) * 0x100000001b3ull;
+    }
+
+    return hash;
+}
+
+int main(int argc, char** argv) {
+    static uint8_t rom[CHIP8_MAX_ROM + 1];
+    static uint8_t screens[MACHINES * CHIP8_SCREEN_BYTES];
+    chip8_machine* machines[MACHINES];
+    uint16_t keys[MACHINES];
+
+    if (argc != 2) {
+        printf("Usage: %s <rom>\n", argv[0]);
+        return 1;
+    }
+
+    if (chip8_abi_version() != CHIP8_ABI_VERSION) {
+        printf("Built against ABI %d, but the library is %u\n", CHIP8_ABI_VERSION, chip8_abi_version());
+        return 1;
+    }
+
+    FILE* file = fopen(argv[1], "rb");
+    if (file == NULL) {
+        printf("Couldn't open %s\n", argv[1]);
+        return 1;
+    }
+
+    const size_t length = fread(rom, 1, sizeof(rom), file);
+    fclose(file);
+
+    for (int n = 0; n < MACHINES; ++n) {
+        machines[n] = chip8_create(0);
+        if (machines[n] == NULL || chip8_load(machines[n], rom, length) != CHIP8_OK) {
+            printf("Couldn't load %s\n", argv[1]);
+            return 1;
+        }
+
+        keys[n] = (uint16_t)(1u << n);
+    }
+
+    chip8_step(machines, keys, MACHINES, FRAMES);
+    chip8_read_screens((const chip8_machine* const*)machines, MACHINES, screens);
+
+    for (int n = 0; n < MACHINES; ++n) {
+        printf("key %x: screen %016llx, machine %016llx\n", n, fnv(screens + n * CHIP8_SCREEN_BYTES, CHIP8_SCREEN_BYTES),
+               (unsigned long long)chip8_hash(machines[n]));
+        chip8_destroy(machines[n]);
+    }
+
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <thread>
+#include "../src/shared.hpp"
+
+// Watches a machine published with `chip8 publish=NAME <rom>` (see src/shared.hpp).
+// Usage: chip8-shared-reader <name> [frames]
+//
+// Polls at 60 Hz, and prints the registers & the screen whenever a new frame was published.
+// Stops after the given number of frames, or runs until interrupted.
+
+using namespace ch8::shared;
+
+static void print(const Snapshot& snapshot) {
+    printf("\x1b[H");   // Home, so the screen is redrawn in place
+    printf("frame %-10llu pc %.4x  i %.4x  sp %.4x  dt %.2x  st %.2x  keys %.4x\n",
+           (unsigned long long)snapshot.frame, snapshot.pc, snapshot.i, snapshot.sp, snapshot.dt, snapshot.st,
+           snapshot.keys);
+
+    for (u32 k = 0; k < 16; ++k) {
+        printf("V%X %.2x%c", k, snapshot.v[k], k == 15 ? '\n' : ' ');
+    }
+
+    for (u32 y = 0; y < ch8::SCREEN_HEIGHT; ++y) {
+        char line[ch8::SCREEN_WIDTH + 1];
+
+        for (u32 x = 0; x < ch8::SCREEN_WIDTH; ++x) {
+            const u32 bit = y * ch8::SCREEN_WIDTH + x;
+            line[x] = snapshot.screen[bit / 8] & (0x80 >> (bit % 8)) ? '#' : ' ';
+        }
+
+        line[ch8::SCREEN_WIDTH] = '\0';
+        printf("%s\n", line);
+    }
+
+    fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        printf("Usage: %s <name> [frames]\n", argv[0]);
+        return 1;
+    }
+
+    try {
+        Subscriber subscriber(argv[1]);
+        const unsigned long long frames = argc > 2 ? strtoull(argv[2], nullptr, 10) : 0;
+
+        Snapshot snapshot;
+        u64 last = 0;
+        unsigned long long shown = 0;
+
+        printf("\x1b[2J");
+
+        while (frames == 0 || shown < frames) {
+            if (subscriber.Read(snapshot) && snapshot.frame != last) {
+                last = snapshot.frame;
+                print(snapshot);
+                ++shown;
+            }
+
+            std::this_thread::sleep_for(std::chrono::microseconds(1000000 / 60));
+        }
+    } catch (const std::exception& e) {
+        printf("%s\n", e.what());
+        return 1;
+    }
+}
@@ -0,0 +1,352 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../src/trace.hpp"
+
+// Queries execution traces (see src/trace.hpp).
+// Usage: chip8-trace <command> <trace> [arguments]
+//
+// info                     Blocks, steps, frames & compression
+// reg <V0-VF|I|SP|DT|ST|S0-SF> [last]   Every change of a register (or the last one)
+// mem <address> [last]     Every write to an address
+// at <step> [count]        The records from a step on
+//
+// reg & mem go through an index (<trace>.idx), built on first use & rebuilt whenever the trace changes.
+// It holds every change of every register & address, sorted by step, so a query is a lookup.
+//
+// Index layout (native byte order, it's a local cache):
+// "CH8TIDX\0", u32 version, u32 key count, u64 trace size, u64 trace mtime,
+// key count + 1 offsets into the entries (u64), then the entries: step << 17 | (frame ? 1 << 16 : 0) | value.
+// Keys 0-63 are registers (REGISTER ids), 64 on are addresses.
+
+using namespace ch8::trace;
+
+static constexpr char MAGIC[8]       = {'C', 'H', '8', 'T', 'I', 'D', 'X', '\0'};
+static constexpr u32  VERSION        = 1;
+static constexpr u32  REGISTER_KEYS  = 64;
+static constexpr u32  KEYS           = REGISTER_KEYS + ch8::MEM_SIZE;
+static constexpr u32  HEADER_LEN     = 32;
+
+struct Index {
+    const u8*  base   = nullptr;
+    std::size_t length = 0;
+    const u64* offsets = nullptr;
+    const u64* entries = nullptr;
+
+    ~Index() {
+        if (base != nullptr) {
+            munmap(const_cast<u8*>(base), length);
+        }
+    }
+};
+
+static void fail(const std::string& message) {
+    fprintf(stderr, "%s\n", message.c_str());
+    exit(1);
+}
+
+// Calls visit(key, entry) for every change in the trace.
+template <typename Visitor>
+static void walk(Reader& reader, Visitor visit) {
+    Record record;
+
+    for (std::size_t b = 0; b < reader.Blocks().size(); ++b) {
+        reader.Load(b);
+
+        while (reader.Next(record)) {
+            const u64 stamp = record.step << 17 | (record.frame ? 1u << 16 : 0);
+
+            for (u8 k = 0; k < record.registers; ++k) {
+                visit(record.ids[k], stamp | record.values[k]);
+            }
+
+            for (u16 k = 0; k < record.writes; ++k) {
+                visit(REGISTER_KEYS + record.addresses[k], stamp | record.bytes[k]);
+            }
+        }
+    }
+}
+
+// Two passes: count the changes of each key, then fill the index in place.
+static void build(const std::string& path, const std::string& indexPath, const struct stat& traced) {
+    Reader reader(path);
+    std::vector<u64> offsets(KEYS + 1, 0);
+
+    walk(reader, [&offsets](u32 key, u64) {
+        ++offsets[key + 1];
+    });
+
+    for (u32 key = 0; key < KEYS; ++key) {
+        offsets[key + 1] += offsets[key];
+    }
+
+    const std::size_t length = HEADER_LEN + offsets.size() * sizeof(u64) + offsets[KEYS] * sizeof(u64);
+    const std::string temporary = indexPath + ".tmp";
+
+    int file = open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (file < 0 || ftruncate(file, length) != 0) {
+        fail(temporary + ": " + strerror(errno));
+    }
+
+    u8* base = static_cast<u8*>(mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0));
+    close(file);
+
+    if (base == MAP_FAILED) {
+        fail(temporary + ": " + strerror(errno));
+    }
+
+    const u32 version = VERSION, keys = KEYS;
+    const u64 size = traced.st_size, mtime = traced.st_mtime;
+    memcpy(base, MAGIC, sizeof(MAGIC));
+    memcpy(base + 8, &version, 4);
+    memcpy(base + 12, &keys, 4);
+    memcpy(base + 16, &size, 8);
+    memcpy(base + 24, &mtime, 8);
+    memcpy(base + HEADER_LEN, offsets.data(), offsets.size() * sizeof(u64));
+
+    u64* entries = reinterpret_cast<u64*>(base + HEADER_LEN + offsets.size() * sizeof(u64));
+    std::vector<u64> fill(offsets.begin(), offsets.end() - 1);
+
+    walk(reader, [entries, &fill](u32 key, u64 entry) {
+        entries[fill[key]++] = entry;
+    });
+
+    munmap(base, length);
+
+    if (rename(temporary.c_str(), indexPath.c_str()) != 0) {
+        fail(indexPath + ": " + strerror(errno));
+    }
+}
+
+static bool current(const Index& index, const struct stat& traced) {
+    u32 version, keys;
+    u64 size, mtime;
+
+    if (index.length < HEADER_LEN || memcmp(index.base, MAGIC, sizeof(MAGIC)) != 0) {
+        return false;
+    }
+
+    memcpy(&version, index.base + 8, 4);
+    memcpy(&keys, index.base + 12, 4);
+    memcpy(&size, index.base + 16, 8);
+    memcpy(&mtime, index.base + 24, 8);
+
+    return version == VERSION && keys == KEYS && size == u64(traced.st_size) && mtime == u64(traced.st_mtime)
+        && index.length >= HEADER_LEN + (KEYS + 1) * sizeof(u64);
+}
+
+static bool map(Index& index, const std::string& indexPath) {
+    int file = open(indexPath.c_str(), O_RDONLY);
+    struct stat info;
+
+    if (file < 0) {
+        return false;
+    }
+
+    if (fstat(file, &info) != 0 || info.st_size == 0) {
+        close(file);
+        return false;
+    }
+
+    void* base = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, file, 0);
+    close(file);
+
+    if (base == MAP_FAILED) {
+        return false;
+    }
+
+    index.base    = static_cast<const u8*>(base);
+    index.length  = info.st_size;
+    index.offsets = reinterpret_cast<const u64*>(index.base + HEADER_LEN);
+    index.entries = index.offsets + KEYS + 1;
+    return true;
+}
+
+static void openIndex(Index& index, const std::string& path) {
+    const std::string indexPath = path + ".idx";
+    struct stat traced;
+
+    if (stat(path.c_str(), &traced) != 0) {
+        fail(path + ": " + strerror(errno));
+    }
+
+    if (map(index, indexPath) && current(index, traced)) {
+        return;
+    }
+
+    if (index.base != nullptr) {
+        munmap(const_cast<u8*>(index.base), index.length);
+        index.base = nullptr;
+    }
+
+    fprintf(stderr, "Indexing %s...\n", path.c_str());
+    build(path, indexPath, traced);
+
+    if (!map(index, indexPath) || !current(index, traced)) {
+        fail(indexPath + ": Couldn't be read back");
+    }
+}
+
+
+// Printing
+
+static const char* registerName(u8 id) {
+    static char name[4];
+
+    switch (id) {
+    case REGISTER_I:  return "I";
+    case REGISTER_SP: return "SP";
+    case REGISTER_DT: return "DT";
+    case REGISTER_ST: return "ST";
+    default:
+        snprintf(name, sizeof(name), id >= REGISTER_STACK ? "S%X" : "V%X", id % 16);
+        return name;
+    }
+}
+
+static i32 parseRegister(const char* text) {
+    for (u32 id = 0; id < REGISTER_COUNT; ++id) {
+        if ((id < 20 || id >= REGISTER_STACK) && strcasecmp(text, registerName(u8(id))) == 0) {
+            return i32(id);
+        }
+    }
+
+    return -1;
+}
+
+static void printEntry(u64 entry) {
+    if (entry & (1u << 16)) {
+        printf("tick after step %llu: %.2x\n", (unsigned long long)(entry >> 17), unsigned(entry & 0xffff));
+    } else {
+        printf("step %llu: %.4x\n", (unsigned long long)(entry >> 17), unsigned(entry & 0xffff));
+    }
+}
+
+static void printChanges(const Index& index, u32 key, bool last) {
+    const u64 first = index.offsets[key], end = index.offsets[key + 1];
+
+    if (first == end) {
+        printf("Never changed\n");
+        return;
+    }
+
+    for (u64 k = last ? end - 1 : first; k < end; ++k) {
+        printEntry(index.entries[k]);
+    }
+}
+
+static void printRecord(const Record& record) {
+    if (record.frame) {
+        printf("           frame %-8llu tick", (unsigned long long)record.frameIndex);
+    } else {
+        printf("step %-10llu frame %-8llu %.4x: %.4x",
+               (unsigned long long)record.step, (unsigned long long)record.frameIndex, record.pc, record.opcode);
+    }
+
+    for (u8 k = 0; k < record.registers; ++k) {
+        printf("  %s=%.*x", registerName(record.ids[k]), record.ids[k] < 16 || record.frame ? 2 : 4, record.values[k]);
+    }
+
+    if (record.writes > 8) {
+        printf("  (%u bytes written)", record.writes);
+    } else {
+        for (u16 k = 0; k < record.writes; ++k) {
+            printf("  [%.3x]=%.2x", record.addresses[k], record.bytes[k]);
+        }
+    }
+
+    putchar('\n');
+}
+
+// Starts from the block that holds the step, so that only one block is decoded before printing.
+static void printFrom(const std::string& path, u64 step, u64 count) {
+    Reader reader(path);
+    const auto& blocks = reader.Blocks();
+
+    std::size_t b = 0;
+    while (b + 1 < blocks.size() && blocks[b + 1].step <= step) {
+        ++b;
+    }
+
+    Record record;
+
+    for (; b < blocks.size() && count > 0; ++b) {
+        reader.Load(b);
+
+        while (count > 0 && reader.Next(record)) {
+            if (record.step >= step && (!record.frame || record.step > step)) {
+                printRecord(record);
+                --count;
+            }
+        }
+    }
+}
+
+static void printInfo(const std::string& path) {
+    Reader reader(path);
+    u64 raw = 0, stored = 0, steps = 0, frames = 0;
+
+    for (std::size_t b = 0; b < reader.Blocks().size(); ++b) {
+        const BlockHeader& block = reader.Blocks()[b];
+        raw += block.raw;
+        stored += block.stored;
+    }
+
+    Record record;
+    if (!reader.Blocks().empty()) {
+        reader.Load(reader.Blocks().size() - 1);
+
+        while (reader.Next(record)) {
+            steps = record.frame ? record.step : record.step + 1;
+            frames = record.frame ? record.frameIndex + 1 : record.frameIndex;
+        }
+    }
+
+    printf("%zu blocks, %llu steps, %llu frames\n", reader.Blocks().size(),
+           (unsigned long long)steps, (unsigned long long)frames);
+    printf("%llu bytes of records, %llu stored (%.1fx)\n", (unsigned long long)raw, (unsigned long long)stored,
+           stored != 0 ? double(raw) / stored : 1.0);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        printf("Usage: %s <info|reg|mem|at> <trace> [arguments]\n", argv[0]);
+        return 1;
+    }
+
+    const std::string command = argv[1];
+    const std::string path = argv[2];
+    const bool last = argc > 4 && strcmp(argv[4], "last") == 0;
+
+    try {
+        if (command == "info") {
+            printInfo(path);
+        } else if (command == "reg" && argc > 3) {
+            const i32 id = parseRegister(argv[3]);
+            if (id < 0) {
+                fail(std::string("Unknown register ") + argv[3]);
+            }
+
+            Index index;
+            openIndex(index, path);
+            printChanges(index, u32(id), last);
+        } else if (command == "mem" && argc > 3) {
+            Index index;
+            openIndex(index, path);
+            printChanges(index, REGISTER_KEYS + (strtoul(argv[3], nullptr, 0) & (ch8::MEM_SIZE - 1)), last);
+        } else if (command == "at" && argc > 3) {
+            printFrom(path, strtoull(argv[3], nullptr, 0), argc > 4 ? strtoull(argv[4], nullptr, 0) : 20);
+        } else {
+            fail("Unknown command " + command);
+        }
+    } catch (const std::exception& e) {
+        fail(e.what());
+    }
+}